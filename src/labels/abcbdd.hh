@@ -29,11 +29,11 @@ namespace labels {
       }
 
       std::tuple<abcbdd, abcbdd, abcbdd> partition (const abcbdd& other) const {
-        return { *this * !other, *this * other, !*this * other };
+        return { this->AndNot (other), *this * other, other.AndNot (*this) };
       }
 
       auto operator<=> (const abcbdd& other) const {
-        return this->GetBDD () <=> other.GetBDD ();
+        return upper::operator<=> (other);
       }
   };
 }
@@ -28,7 +28,7 @@ namespace labels {
       }
 
       std::tuple<buddybdd, buddybdd, buddybdd> partition (const buddybdd& other) const {
-        return { *this * !other, *this * other, !*this * other };
+        return { this->AndNot (other), *this * other, other.AndNot (*this) };
       }
 
       auto operator<=> (const buddybdd& other) const {
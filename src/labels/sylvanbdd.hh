@@ -6,7 +6,6 @@
 namespace labels {
   struct sylvanbdd_letter : public sylvan::Bdd {
       // This is rarely needed, only by implementations that are not letter-agnostic.
-      // (currently, upset::contains).
       sylvanbdd_letter& operator= (const sylvan::Bdd& other) {
         sylvan::Bdd::operator= (other);
         return *this;
@@ -32,13 +31,32 @@ namespace labels {
       static sylvanbdd bddZero () { return upper::bddZero (); }
       static sylvanbdd bddOne () { return upper::bddOne (); }
 
+      // Negation is free with complement edges, so this is a single and.
+      sylvanbdd AndNot (const sylvanbdd& other) const { return *this * !other; }
+      sylvanbdd Xnor (const sylvanbdd& other) const { return upper::Xnor (other); }
+      sylvanbdd Ite (const sylvanbdd& g, const sylvanbdd& h) const { return upper::Ite (g, h); }
+      // Exists vars. (*this & other), without building the conjunction.
+      sylvanbdd AndAbstract (const sylvanbdd& other, const sylvanbdd& vars) const {
+        return upper::AndAbstract (other, sylvan::BddSet (vars));
+      }
+
       bool empty () const {
         return this->isZero ();
       }
 
+      // The value of the function when variable v is val (v), read off the
+      // nodes without making any BDD.
+      template <typename Valuation>
+      bool eval (const Valuation& val) const {
+        auto b = GetBDD ();
+        while (not sylvan::sylvan_isconst (b))
+          b = val (sylvan::sylvan_var (b)) ? sylvan::sylvan_high (b) : sylvan::sylvan_low (b);
+        return b == sylvan::sylvan_true;
+      }
+
       std::tuple<sylvanbdd, sylvanbdd, sylvanbdd>
       partition (const sylvanbdd& other) const {
-        return { *this * !other, *this * other, !*this * other };
+        return { AndNot (other), *this * other, other.AndNot (*this) };
       }
 
       auto operator<=> (const sylvanbdd& other) const {
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <tuple>
+
+#include <utils/truthtable.hh>
+
+namespace labels {
+  // Labels over at most N variables, without a BDD manager.
+  template <size_t N>
+  class truthtable : public utils::truthtable<N> {
+      using upper = utils::truthtable<N>;
+
+    public:
+      truthtable () : upper () {}
+      truthtable (const upper& b) : upper (b) {}
+
+      using letter_type = upper;
+
+      static truthtable fullset () {
+        return truthtable (upper::bddOne ());
+      }
+
+      truthtable operator* (const truthtable& other) const {
+        return upper::operator* (other);
+      }
+      static truthtable bddVar (int idx) { return upper::bddVar (idx); }
+      static truthtable bddZero () { return upper::bddZero (); }
+      static truthtable bddOne () { return upper::bddOne (); }
+
+      bool empty () const {
+        return this->isZero ();
+      }
+
+      std::tuple<truthtable, truthtable, truthtable> partition (const truthtable& other) const {
+        return { this->AndNot (other), *this * other, other.AndNot (*this) };
+      }
+  };
+}
@@ -0,0 +1,71 @@
+#include <algorithm>
+
+#include <sylvan.h>
+
+#include <meta_bdd_states_are_bddvars/meta_bdd.hh>
+
+namespace MBDD {
+  std::set<const master_bmeta_bdd*> master_bmeta_bdd::live_masters;
+  std::mutex master_bmeta_bdd::live_masters_mutex;
+
+  // Sylvan's mark callbacks take no argument, hence the list of live masters.
+  VOID_TASK_0 (gc_mark_live_masters) {
+    using namespace sylvan;
+    master_bmeta_bdd::for_each_live_root ([&] (auto bdd) { mtbdd_gc_mark_rec (bdd); });
+  }
+
+  void master_bmeta_bdd::register_gc_roots () {
+    static std::once_flag registered;
+    std::call_once (registered, [] { sylvan::sylvan_gc_add_mark (TASK (gc_mark_live_masters)); });
+    auto lock = std::lock_guard (live_masters_mutex);
+    live_masters.insert (this);
+  }
+
+  // Computes the conjunctions of transitions that intersection_union starts
+  // with.  The outputs are protected Bdd's, so that a garbage collection
+  // triggered by another worker keeps the ones already computed.
+  using bdd_pair = std::pair<sylvan::BDD, sylvan::BDD>; // No commas in task macros.
+  VOID_TASK_3 (compute_conjs, const bdd_pair*, conjs, sylvan::Bdd*, out, size_t, n) {
+    if (n == 1) {
+      *out = sylvan::Bdd (conjs->first) * sylvan::Bdd (conjs->second);
+      return;
+    }
+    SPAWN (compute_conjs, conjs, out, n / 2);
+    CALL (compute_conjs, conjs + n / 2, out + n / 2, n - n / 2);
+    SYNC (compute_conjs);
+  }
+
+  std::vector<master_bmeta_bdd::meta_bdd>
+  master_bmeta_bdd::products (std::span<const product_request> requests) {
+    // The master itself is not thread-safe, so only the top-level
+    // conjunctions, which are pure Sylvan operations, are run as parallel
+    // tasks.  The requests are then computed in order, starting from these.
+    auto needs_conj = [] (const product_request& r) {
+      return r.lhs.state != r.rhs.state and r.lhs.state > STATE_FULL and r.rhs.state > STATE_FULL;
+    };
+    auto key = [this] (const product_request& r) {
+      return bdd_pair (delta[r.lhs.state], delta_prime[r.rhs.state]);
+    };
+
+    std::vector<bdd_pair> conjs;
+    for (auto&& r : requests)
+      if (needs_conj (r))
+        conjs.push_back (key (r));
+    std::sort (conjs.begin (), conjs.end ());
+    conjs.erase (std::unique (conjs.begin (), conjs.end ()), conjs.end ());
+
+    auto results = std::vector<Bdd> (conjs.size ());
+    if (not conjs.empty ())
+      RUN (compute_conjs, conjs.data (), results.data (), conjs.size ());
+
+    std::vector<meta_bdd> res;
+    res.reserve (requests.size ());
+    for (auto&& r : requests) {
+      const Bdd* conj = nullptr;
+      if (needs_conj (r))
+        conj = &results[std::lower_bound (conjs.begin (), conjs.end (), key (r)) - conjs.begin ()];
+      res.push_back (r.lhs.intersection_union (r.rhs, r.intersection, std::identity {}, 0, conj));
+    }
+    return res;
+  }
+}
@@ -8,6 +8,7 @@
 #include <vector>
 #include <map>
 #include <deque>
+#include <mutex>
 
 #include <functional>
 
@@ -91,6 +92,10 @@ namespace MBDD {
       bool accepts (std::span<const letter_type> w) const;
       bool accepts (std::initializer_list<letter_type> w) const { return accepts (std::span (w)); }
       bool accepts (std::vector<letter_type> w) const           { return accepts (std::span (w)); }
+      // The word of length len whose k-th letter gives variable v the value
+      // val (k, v).  Transitions are walked directly, no letter is built.
+      template <typename Valuation>
+      bool accepts_valuations (size_t len, const Valuation& val) const;
 
       template <typename T>
       bool rejects (T&& t) const { return not accepts (std::forward<T> (t)); }
@@ -138,7 +143,8 @@ namespace MBDD {
       template <typename Map = std::identity, typename Hash = size_t,
                 typename T = MMBdd, typename = force_const<T>>
       bmeta_bdd intersection_union (const bmeta_bdd& other, bool intersection,
-                                    const Map& map = {}, const Hash& map_hash = 0) const;
+                                    const Map& map = {}, const Hash& map_hash = 0,
+                                    const Bdd* precomputed_conj = nullptr) const;
 
       template <typename T>
       friend std::ostream& operator<< (std::ostream& os, const bmeta_bdd<T>& b);
@@ -165,16 +171,26 @@ namespace MBDD {
       friend meta_bdd;
       friend const_meta_bdd;
 
-      master_meta_bdd () : delta (3) { }
+      master_meta_bdd () : delta (3), delta_self (3), neighbors_start (1, 0) { }
+      // Registered by address with the garbage collector, see init ().
+      master_meta_bdd (const master_meta_bdd&) = delete;
+      master_meta_bdd& operator= (const master_meta_bdd&) = delete;
+      ~master_meta_bdd () {
+        auto lock = std::lock_guard (live_masters_mutex);
+        live_masters.erase (this);
+      }
 
       void init () {
+        register_gc_roots ();
+
         statevars = BDDVAR_SELF * BDDVAR_FULL * BDDVAR_EMPTY;
         statevarsprime = BDDVAR_FULL_PRIME * BDDVAR_EMPTY_PRIME;
         statevars_to_statevarsprime.put (VARNUM_FULL, BDDVAR_FULL_PRIME);
         statevars_to_statevarsprime.put (VARNUM_EMPTY, BDDVAR_EMPTY_PRIME);
 
-        delta[STATE_FULL] = BDDVAR_FULL;
-        delta[STATE_EMPTY] = BDDVAR_EMPTY;
+        delta[STATE_FULL] = BDDVAR_FULL.GetBDD ();
+        delta[STATE_EMPTY] = BDDVAR_EMPTY.GetBDD ();
+        delta_self[STATE_FULL] = delta_self[STATE_EMPTY] = BDDVAR_SELF.GetBDD ();
         accepting_states.insert (STATE_FULL);
 
         trans_to_state_noself[ACC][BDDVAR_FULL.GetBDD ()] = STATE_FULL;
@@ -182,6 +198,11 @@ namespace MBDD {
 
         trans_to_state_noself[REJ][BDDVAR_EMPTY.GetBDD ()] = STATE_EMPTY;
         trans_to_state_self[REJ][BDDVAR_SELF.GetBDD ()] = STATE_EMPTY;
+
+        for (size_t state = 0; state < delta.size (); ++state) {
+          store_neighbors (state);
+          delta_prime.push_back (Bdd (delta[state]).Compose (statevars_to_statevarsprime).GetBDD ());
+        }
       }
 
       auto full ()  { return bmeta_bdd (*this, STATE_FULL);  }
@@ -264,7 +285,8 @@ namespace MBDD {
         auto state = delta.size ();
 
         auto trans_noself = self_to_state (trans, state);
-        delta.emplace_back (trans_noself);
+        delta.push_back (trans_noself.GetBDD ());
+        delta_self.push_back (trans.GetBDD ());
 
         trans_to_state_self[is_accepting][trans.GetBDD ()] = state;
         trans_to_state_noself[is_accepting][trans_noself.GetBDD ()] = state;
@@ -278,11 +300,39 @@ namespace MBDD {
         statevarsprime *= state_varnum_prime_bdd;
         statevars_to_statevarsprime.put (state_varnum, state_varnum_prime_bdd);
 
+        // This needs statevars to contain the new state, as it appears in
+        // trans_noself if it has a self loop.
+        store_neighbors (state);
+        delta_prime.push_back (trans_noself.Compose (statevars_to_statevarsprime).GetBDD ());
+
         check_consistency ();
 
         return bmeta_bdd<master_meta_bdd> (*this, state);
       }
 
+      // Calls mark on the transitions of all the live masters; this is done
+      // by the task that Sylvan's garbage collector calls.
+      template <typename Mark>
+      static void for_each_live_root (const Mark& mark) {
+        auto lock = std::lock_guard (live_masters_mutex);
+        for (auto&& mmbdd : live_masters) {
+          for (auto&& bdd : mmbdd->delta)
+            mark (bdd);
+          for (auto&& bdd : mmbdd->delta_self)
+            mark (bdd);
+          for (auto&& bdd : mmbdd->delta_prime)
+            mark (bdd);
+          for (auto&& [_, label] : mmbdd->neighbors_flat)
+            mark (label);
+        }
+      }
+
+      // Computes many products at once, returned in the order of the requests.
+      // Only the top-level conjunctions of transitions are run in parallel, as
+      // Lace tasks; the product recursions that follow are sequential.
+      struct product_request;
+      std::vector<meta_bdd> products (std::span<const product_request> requests);
+
     private:
       bool is_accepting (size_t state) const {
         return accepting_states.contains (state);
@@ -298,13 +348,32 @@ namespace MBDD {
         return Bdd (sylvan_project (t.GetBDD (), statevars.GetBDD ()));
       }
 
+      // Splits delta[state] into (destination, label) pairs.  Transitions are
+      // never modified, so this is done once, when the state is made.
+      void store_neighbors (size_t state) {
+        assert (neighbors_start.size () == state + 1);
+        auto dt = Bdd (delta[state]);
+        // The OR of destination states.
+        auto states = dt.isZero () ? Bdd::bddZero () : project_to_statevars (dt);
+
+        while (not states.isZero ()) {
+          assert (states.Then ().isOne ());
+          assert (is_varnumstate (states.TopVar ()));
+          auto bddstate = Bdd::bddVar (states.TopVar ());
+          auto label = dt.ExistAbstract (bddstate).UnivAbstract (statevars);
+          neighbors_flat.emplace_back (varnum_to_state (states.TopVar ()), label.GetBDD ());
+          states = states.Else ();
+        }
+        neighbors_start.push_back (neighbors_flat.size ());
+      }
+
       size_t successor (size_t state, const Bdd& l) const {
-        auto t = project_to_statevars (delta[state] * l);
+        auto t = project_to_statevars (Bdd (delta[state]) * l);
         assert ([&] () {
           if (t.isTerminal () or not (t.Then ().isOne () and t.Else ().isZero ())) {
-            std::cout << "label: " << delta[state]
+            std::cout << "label: " << Bdd (delta[state])
                       << ", letter: " << l
-                      << ", combine to: " << delta[state] * l
+                      << ", combine to: " << Bdd (delta[state]) * l
                       << ", which is not valid.\n";
             return false;
           }
@@ -313,13 +382,39 @@ namespace MBDD {
         return varnum_to_state (t.TopVar ());
       }
 
+      // Letter variables come before the state variables, so walking down
+      // delta[state] along val stops at the destination.
+      template <typename Valuation>
+      size_t successor_eval (size_t state, const Valuation& val) const {
+        auto b = delta[state];
+        while (not sylvan::sylvan_isconst (b) and not is_varnumstate (sylvan::sylvan_var (b)))
+          b = val (sylvan::sylvan_var (b)) ? sylvan::sylvan_high (b) : sylvan::sylvan_low (b);
+        if (b == sylvan::sylvan_false)
+          return STATE_EMPTY;
+        assert (not sylvan::sylvan_isconst (b) and sylvan::sylvan_high (b) == sylvan::sylvan_true);
+        return varnum_to_state (sylvan::sylvan_var (b));
+      }
+
       bool is_trans_deterministic (Bdd trans) const;
       void check_consistency () const;
 
       template <typename T>
       friend std::ostream& operator<< (std::ostream& os, const bmeta_bdd<T>& b);
 
-      std::vector<Bdd> delta;
+      void register_gc_roots ();
+
+      // Transitions are kept as raw handles, and protected in bulk by the
+      // garbage collection task rather than one by one by Sylvan's Bdd
+      // wrapper.  delta has the self loops resolved, delta_self is the
+      // transition as given to make; these are exactly the keys of
+      // trans_to_state_noself and trans_to_state_self, respectively.
+      std::vector<BDD> delta, delta_self;
+      // delta with all states primed, for the products.
+      std::vector<BDD> delta_prime;
+      // The neighbors of state s are neighbors_flat[i] for neighbors_start[s] <=
+      // i < neighbors_start[s + 1]; labels are protected as delta is.
+      std::vector<size_t> neighbors_start;
+      std::vector<std::pair<size_t, BDD>> neighbors_flat;
       std::set<size_t> accepting_states;
       std::map<BDD, size_t> trans_to_state_self[2], trans_to_state_noself[2];
       enum {
@@ -327,6 +422,14 @@ namespace MBDD {
       };
       Bdd statevars, statevarsprime;
       BddMap statevars_to_statevarsprime;
+
+      static std::set<const master_meta_bdd*> live_masters;
+      static std::mutex live_masters_mutex;
+  };
+
+  struct master_bmeta_bdd::product_request {
+      bool intersection;
+      meta_bdd lhs, rhs;
   };
 }
 
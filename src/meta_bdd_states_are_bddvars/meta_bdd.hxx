@@ -15,58 +15,47 @@ namespace MBDD {
     return mmbdd.is_accepting (cur_state);
   }
 
+  template <typename MMBdd>
+  template <typename Valuation>
+  inline bool bmeta_bdd<MMBdd>::accepts_valuations (size_t len, const Valuation& val) const {
+    auto cur_state = state;
+    for (size_t k = 0; k < len; ++k) {
+      cur_state = mmbdd.successor_eval (cur_state, [&] (int var) { return val (k, var); });
+      if (cur_state == STATE_FULL)
+        return true;
+      if (cur_state == STATE_EMPTY)
+        return false;
+    }
+    return mmbdd.is_accepting (cur_state);
+  }
+
   template <typename MMBdd>
   class bmeta_bdd<MMBdd>::neighbor_iterator {
     public:
-      neighbor_iterator (MMBdd& mmbdd, Bdd dt) :
-        mmbdd {mmbdd},
-        dt {dt},
-        // states is the OR of destination states.
-        states {dt.isZero () ? Bdd::bddZero () : mmbdd.project_to_statevars (dt)},
-        state {mmbdd}
-      {
-        ++(*this);
-      }
-
-      neighbor_iterator& operator++ () {
-        if (states == Bdd::bddZero ()) {
-          state.state = 0;
-          label = Bdd::bddZero ();
-          return *this;
-        }
-
-        assert (states.Then ().isOne ());
-        assert (is_varnumstate (states.TopVar ()));
-
-        auto bddstate = Bdd::bddVar (states.TopVar ());
-        label = dt.ExistAbstract (bddstate).UnivAbstract (mmbdd.statevars);
-        state.state = varnum_to_state (states.TopVar ());
-        states = states.Else ();
-        return *this;
-      }
-
-      bool operator!= (const neighbor_iterator& other) const {
-        return states != other.states or state != other.state or label != other.label;
+      // This uses an index rather than a pointer as neighbors_flat may grow
+      // while iterating.
+      neighbor_iterator (MMBdd& mmbdd, size_t pos) : mmbdd {mmbdd}, pos {pos} {}
+      neighbor_iterator& operator++ () { ++pos; return *this; }
+      bool operator!= (const neighbor_iterator& other) const { return pos != other.pos; }
+      auto operator* () const {
+        auto&& [state, label] = mmbdd.neighbors_flat[pos];
+        return std::pair (bmeta_bdd (mmbdd, state), Bdd (label));
       }
-
-      auto operator* () const { return std::pair (state, label); }
     private:
       MMBdd& mmbdd;
-      Bdd dt, states;
-      bmeta_bdd state;
-      Bdd label;
+      size_t pos;
   };
 
   template <typename MMBdd>
   inline auto bmeta_bdd<MMBdd>::neighbors () const {
     struct helper {
         MMBdd& mmbdd;
-        Bdd dt;
-        helper (MMBdd& mmbdd, Bdd dt) : mmbdd {mmbdd}, dt {dt} {}
-        auto begin () const { return neighbor_iterator (mmbdd, dt); }
-        auto end () const { return neighbor_iterator (mmbdd, Bdd::bddZero ()); }
+        size_t state;
+        helper (MMBdd& mmbdd, size_t state) : mmbdd {mmbdd}, state {state} {}
+        auto begin () const { return neighbor_iterator (mmbdd, mmbdd.neighbors_start[state]); }
+        auto end () const { return neighbor_iterator (mmbdd, mmbdd.neighbors_start[state + 1]); }
     };
-    return helper (mmbdd, mmbdd.delta[state]);
+    return helper (mmbdd, state);
   }
 
   template <typename MMBdd>
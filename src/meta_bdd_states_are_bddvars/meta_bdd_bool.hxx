@@ -13,7 +13,8 @@ namespace MBDD {
   template <typename MMBdd>
   template <typename Map, typename Hash, typename, typename EnabledOnlyIfMMBddIsNotConst>
   bmeta_bdd<MMBdd> bmeta_bdd<MMBdd>::intersection_union (const bmeta_bdd& other, bool intersection,
-                                                         const Map& map, const Hash& map_hash) const {
+                                                         const Map& map, const Hash& map_hash,
+                                                         const Bdd* precomputed_conj) const {
     typedef std::tuple<size_t, size_t, bool, Hash> tuple_t;
     static std::map<tuple_t, size_t> iu_cache;
 
@@ -56,9 +57,10 @@ namespace MBDD {
         return cache (nomap ? state : apply (map).state);
     }
 
-    // Compute the conjunction of deltas with the second primed.
-    auto conj = mmbdd.delta[state] *
-      mmbdd.delta[other.state].Compose (mmbdd.statevars_to_statevarsprime);
+    // Compute the conjunction of deltas with the second primed, unless the
+    // caller already did.
+    auto conj = precomputed_conj ? *precomputed_conj :
+      Bdd (mmbdd.delta[state]) * Bdd (mmbdd.delta_prime[other.state]);
 
     auto to_make = std::list<std::pair<Bdd, size_t>> ();
     auto all_labels = Bdd::bddZero ();
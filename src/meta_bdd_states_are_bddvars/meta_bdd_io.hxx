@@ -37,7 +37,7 @@ namespace MBDD {
     os << state;
     already_printed.insert (state);
 
-    auto trans = mmbdd.delta[state];
+    auto trans = Bdd (mmbdd.delta[state]);
 
     if (mmbdd.is_accepting (state))
       os << "(acc)";
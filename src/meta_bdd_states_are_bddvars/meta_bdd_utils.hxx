@@ -23,7 +23,7 @@ namespace MBDD {
         return w;
 
       auto dontwant = state_to_bddvar (cur_state) * (accepted ? BDDVAR_EMPTY : BDDVAR_FULL);
-      auto future = mmbdd.delta[cur_state].UnivAbstract (dontwant).PickOneCube ();
+      auto future = Bdd (mmbdd.delta[cur_state]).UnivAbstract (dontwant).PickOneCube ();
 
       // Extract the state and label
       letter_type label;
@@ -115,9 +115,17 @@ namespace MBDD {
         return ret;
       }
 
+      // In place, so that adding transitions one by one is not quadratic.
       transition& operator+= (const transition& other) {
-        // stub
-        return (*this = *this + other);
+        for (auto&& [s, ls] : other) {
+          auto&& [it, inserted] = this->try_emplace (s, ls);
+          if (not inserted)
+            it->second = it->second + ls;
+        }
+        if (other._has_self)
+          _self_labels = _has_self ? LetterSet (_self_labels + other._self_labels) : other._self_labels;
+        _has_self = _has_self or other._has_self;
+        return *this;
       }
 
       // Implementing <=> seems overkill for the moment:
@@ -199,6 +207,10 @@ namespace MBDD {
 
       bool accepts (std::span<const letter_type> w) const;
       bool accepts (std::initializer_list<letter_type> w) const { return accepts (std::span (w)); }
+      // The word of length len whose k-th letter gives variable v the value
+      // val (k, v).  Labels are evaluated directly, no letter is built.
+      template <typename Valuation>
+      bool accepts_valuations (size_t len, const Valuation& val) const;
 
       template <typename T>
       bool rejects (T&& t) const { return not accepts (std::forward<T> (t)); }
@@ -448,6 +460,14 @@ namespace MBDD {
         return STATE_EMPTY;
       }
 
+      template <typename Valuation>
+      state_t successor_eval (state_t state, const Valuation& val) const {
+        for (auto&& [dest, labels] : delta[state])
+          if (labels.eval (val))
+            return dest;
+        return STATE_EMPTY;
+      }
+
       bool is_trans_deterministic (transition_type trans) const;
       void check_consistency () const;
 
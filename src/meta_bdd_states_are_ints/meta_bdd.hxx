@@ -15,6 +15,20 @@ namespace MBDD {
     return mmbdd.is_accepting (cur_state);
   }
 
+  template <typename MMBdd>
+  template <typename Valuation>
+  inline bool imeta_bdd<MMBdd>::accepts_valuations (size_t len, const Valuation& val) const {
+    auto cur_state = state;
+    for (size_t k = 0; k < len; ++k) {
+      cur_state = mmbdd.successor_eval (cur_state, [&] (int var) { return val (k, var); });
+      if (cur_state == STATE_FULL)
+        return true;
+      if (cur_state == STATE_EMPTY)
+        return false;
+    }
+    return mmbdd.is_accepting (cur_state);
+  }
+
   template <typename MMBdd>
   template <typename Iterator>
   class imeta_bdd<MMBdd>::neighbor_iterator {
@@ -20,6 +20,9 @@ using upset_bdd = upset::upset_adhoc<mmbdd_t>;
 
 using value_t = upset_bdd::value_type;
 
+// Reorder the label variables between fixpoint iterations (BuDDy labels).
+static bool reorder_labels = false;
+
 struct transition_view {
     std::vector<value_t> budgets;
     std::vector<value_t> backward_deltas;
@@ -65,13 +68,14 @@ std::ostream& operator<< (std::ostream& out, const std::vector<T>& v) {
 }
 
 static bool backward_coverability (const std::vector<value_t>& init,
-                                   std::list<std::vector<value_t>>& targets,
+                                   const std::list<std::vector<value_t>>& targets,
                                    const std::vector<transition_view>& transitions) {
-  auto B = upset_bdd (mmbdd, targets.front ()), Bprime = B;
-
-  targets.pop_front ();
-  for (auto&& el : targets)
-    Bprime |= upset_bdd (mmbdd, el);
+  auto Bprime = upset_bdd (mmbdd, std::vector (targets.begin (), targets.end ())), B = Bprime;
+  auto deltas = std::vector<std::vector<value_t>> (), budgets = deltas;
+  for (auto&& t : transitions) {
+    deltas.push_back (t.backward_deltas);
+    budgets.push_back (t.budgets);
+  }
 
   size_t i = 0;
 
@@ -80,23 +84,26 @@ static bool backward_coverability (const std::vector<value_t>& init,
               << " Bprime size is " << Bprime.mbdd_size ()
               << std::endl;
     std::cout << "Bprime is: " << Bprime.get_mbdd () << std::endl;
+    if constexpr (std::is_same_v<mmbdd_t::letter_set_type, labels::buddybdd>)
+      if (reorder_labels)
+        utils::buddybdd::reorder ();
     B = Bprime;
-    for (auto&& t : transitions) {
-      std::cout << "Applying transition deltas " << t.backward_deltas << std::endl;
-      auto mt = (B + t.backward_deltas);
-      std::cout << "Applying transition budgets " << t.budgets << std::endl;
-      mt &= t.budgets;
-      std::cout << "Adding to Bprime" << std::endl;
-      if (mt.contains (init))
-        return true;
-      Bprime |= mt;
-    }
+    std::cout << "Applying " << transitions.size () << " transitions" << std::endl;
+    auto pres = B.pre_all (deltas, budgets);
+    if (pres.contains (init))
+      return true;
+    std::cout << "Adding to Bprime" << std::endl;
+    Bprime |= pres;
   } while (B != Bprime);
 
   return false;
 }
 
 int main (int argc, char* argv[]) {
+  if (argc == 3 and std::string (argv[1]) == "--reorder") {
+    reorder_labels = true;
+    argv++, argc--;
+  }
   if (argc != 2)
     return 1;
 
@@ -1,6 +1,10 @@
 #pragma once
 
 namespace upset {
+  // Upsets memoize their operations in static caches keyed by meta-BDDs and
+  // labels, shared by all upsets of a type.  They are therefore
+  // single-threaded: all upsets of a type must be used from one thread, with
+  // one master meta-BDD and one label manager.
   template <typename MMBdd>
   class upset;
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <bit>
+
 #include <upset.hh>
 
 #include <meta_bdd_states_are_bddvars/meta_bdd.hh>
@@ -33,12 +35,20 @@ namespace upset {
         : mmbdd {mmbdd}, mbdd {m}, dim {d} {}
 
     public:
+      // The empty upset of dimension d.
+      upset_adhoc (master_meta_bdd& mmbdd, size_t d)
+        : upset_adhoc (mmbdd, mmbdd.empty (), d) {}
+
       upset_adhoc (master_meta_bdd& mmbdd, const std::vector<value_type>& v);
 
       upset_adhoc (master_meta_bdd& mmbdd,
              std::initializer_list<value_type> v) :
         upset_adhoc (mmbdd, std::vector (v)) {}
 
+      // The upward closure of the nonempty set vs, built by balanced unions of
+      // its minimal elements rather than one vector at a time.
+      upset_adhoc (master_meta_bdd& mmbdd, std::span<const std::vector<value_type>> vs);
+
       bool operator== (const upset_adhoc& other) const {
         // Don't compare oranges and apples
         assert (&mmbdd == &other.mmbdd and dim == other.dim);
@@ -69,36 +79,24 @@ namespace upset {
       upset_adhoc& operator|= (std::initializer_list<value_type> v) { return ((*this) |= upset_adhoc (mmbdd, v)); }
 
       upset_adhoc operator+ (std::span<const value_type> v) const {
-        auto new_upset = *this;
-
-        for (size_t i = 0; i < dim; ++i) {
-          if (v[i] == 0)
-            continue;
-          Bdd all_other_zeros = Bdd::bddOne ();
-          for (size_t j = 0; j < dim; ++j)
-            if (j != i)
-              all_other_zeros *= !Bdd::bddVar (j);
+        return plus (v, {});
+      }
 
-          if constexpr (std::is_same_v<Bdd, labels::sylvanbdd>) {
-            auto map = sylvan::BddMap (i, !Bdd::bddVar (i));
-            auto&& [_, s] = plus_one_dim (new_upset.mbdd, Bdd::bddVar (i),
-                                          [&] (const auto& l) { return l.Compose (map); },
-                                          all_other_zeros,
-                                          std::abs (v[i]), (v[i] < 0), false);
-            new_upset.mbdd = s;
-          }
-          else {
-            auto map = typename Bdd::remap_t ();
-            map[i] = !Bdd::bddVar (i);
-            auto&& [_, s] = plus_one_dim (new_upset.mbdd, Bdd::bddVar (i),
-                                          [&] (const auto& l) { return l.Remap (map); },
-                                          all_other_zeros,
-                                          std::abs (v[i]), (v[i] < 0), false);
-            new_upset.mbdd = s;
-          }
-        }
-        return new_upset;
+      // The predecessors through a Petri transition, (*this + delta) &
+      // upset (budget), with each dimension shifted and raised to its budget
+      // in the same pass.
+      upset_adhoc pre (std::span<const value_type> delta, std::span<const value_type> budget) const {
+        assert (budget.size () == dim);
+        return plus (delta, budget);
       }
+      upset_adhoc pre (const std::vector<value_type>& delta, const std::vector<value_type>& budget) const {
+        return pre (std::span (delta), std::span (budget));
+      }
+
+      // The union of the predecessors through each transition t, given by
+      // deltas[t] and budgets[t].
+      upset_adhoc pre_all (std::span<const std::vector<value_type>> deltas,
+                           std::span<const std::vector<value_type>> budgets) const;
 
       upset_adhoc& operator= (const upset_adhoc& other) {
         assert (&mmbdd == &other.mmbdd);
@@ -110,25 +108,25 @@ namespace upset {
       upset_adhoc& operator+= (std::span<const value_type> v) { return ((*this) = (*this) + v); }
       upset_adhoc& operator+= (std::initializer_list<value_type> v) { return (operator+=) (std::span (v)); }
 
-      bool contains (std::span<const value_type> sv) const {
-        // Make a copy as we're going to shift all these values.
-        std::vector<value_type> v (sv.begin (), sv.end ());
-        std::vector<letter_type> w;
-
+      bool contains (std::span<const value_type> v) const {
         assert (v.size () == dim);
-        bool is_zero = false;
-        while (not is_zero) {
-          is_zero = true;
-          typename Bdd::letter_type bits;
-          bits = Bdd::bddOne ();
-          for (size_t i = 0; i < dim; ++i) {
-            bits *= (v[i] % 2) ? Bdd::bddVar (i) : !Bdd::bddVar (i);
-            if ((v[i] >>= 1))
-              is_zero = false;
-          }
-          w.push_back (bits);
-        }
-        return mbdd.accepts (w);
+        // One letter per bit of the largest value, least significant first,
+        // and at least one.
+        size_t len = 1;
+        for (auto x : v)
+          len = std::max (len, (size_t) std::bit_width ((size_t) x));
+        return mbdd.accepts_valuations (len, [&] (size_t k, int var) {
+          return (size_t) var < dim and ((v[var] >> k) & 1);
+        });
+      }
+
+      // The membership of each of vs, in order.
+      std::vector<bool> contains (std::span<const std::vector<value_type>> vs) const {
+        auto res = std::vector<bool> ();
+        res.reserve (vs.size ());
+        for (auto&& v : vs)
+          res.push_back (contains (v));
+        return res;
       }
 
       bool contains (std::initializer_list<value_type> v) const {
@@ -171,29 +169,74 @@ namespace upset {
       meta_bdd mbdd;
       size_t dim;
 
-      meta_bdd up_mbdd_high_branch (value_type value, size_t dim) {
-        if (value == 0)
-          return mmbdd.full ();
-        if (value % 2 == 1)
-          return mmbdd.make (Bdd::bddVar (dim) * up_mbdd_high_branch (value >> 1, dim) +
-                             !Bdd::bddVar (dim) * up_mbdd_low_branch (value >> 1, dim), false);
-        return mmbdd.make (Bdd::bddOne () * up_mbdd_high_branch (value >> 1, dim), false);
+      // The upward closure of v.  Reading the bits b of the least
+      // significant position leaves (v - b + 1) / 2 to reach, so the states
+      // are the vectors left to reach, each made once.
+      meta_bdd up_mbdd (const std::vector<value_type>& v) const;
+      meta_bdd up_mbdd (std::span<const std::vector<value_type>> vs) const {
+        if (vs.size () == 1)
+          return up_mbdd (vs.front ());
+        auto half = vs.size () / 2;
+        return up_mbdd (vs.first (half)) | up_mbdd (vs.subspan (half));
       }
 
-      meta_bdd up_mbdd_low_branch (value_type value, size_t dim) {
-        if (value == 0)
-          return mmbdd.make (!Bdd::bddVar (dim) * mmbdd.self () +
-                             Bdd::bddVar (dim) * mmbdd.full (), false);
-        if (value % 2 == 0)
-          return mmbdd.make (Bdd::bddVar (dim) * up_mbdd_high_branch (value >> 1, dim) +
-                             !Bdd::bddVar (dim) * up_mbdd_low_branch (value >> 1, dim), false);
-        return mmbdd.make (Bdd::bddOne () * up_mbdd_low_branch (value >> 1, dim), false);
+      // For each dimension i, the labels where all the other dimensions are 0.
+      const std::vector<Bdd>& all_other_zeros () const {
+        static auto cache = utils::make_cache<std::vector<Bdd>> (dim);
+        auto cached = cache.get (dim);
+        if (cached)
+          return *cached;
+        auto masks = std::vector<Bdd> (dim, Bdd::bddOne ());
+        for (size_t i = 0; i < dim; ++i)
+          for (size_t j = 0; j < dim; ++j)
+            if (j != i)
+              masks[i] *= !Bdd::bddVar (j);
+        return cache (masks, dim);
+      }
+
+      // Adds v, then keeps the vectors above budget if it is nonempty.
+      upset_adhoc plus (std::span<const value_type> v, std::span<const value_type> budget) const {
+        assert (v.size () == dim);
+        auto new_upset = *this;
+        const auto& masks = all_other_zeros ();
+
+        for (size_t i = 0; i < dim; ++i) {
+          auto b = budget.empty () ? 0 : budget[i];
+          if (v[i] == 0 and b == 0)
+            continue;
+          if constexpr (std::is_same_v<Bdd, labels::sylvanbdd>) {
+            auto map = sylvan::BddMap (i, !Bdd::bddVar (i));
+            auto&& [_, s] = plus_one_dim (new_upset.mbdd, Bdd::bddVar (i),
+                                          [&] (const auto& l) { return l.Compose (map); },
+                                          masks[i],
+                                          std::abs (v[i]), (v[i] < 0), false, b);
+            new_upset.mbdd = s;
+          }
+          else {
+            // Kept across calls, as the label backend may cache by map.
+            static auto flip_cache = utils::make_cache<typename Bdd::remap_t> (i);
+            auto map = flip_cache.get (i);
+            if (not map) {
+              auto flip_i = typename Bdd::remap_t ();
+              flip_i[i] = !Bdd::bddVar (i);
+              map = &flip_cache (flip_i, i);
+            }
+            auto&& [_, s] = plus_one_dim (new_upset.mbdd, Bdd::bddVar (i),
+                                          [&] (const auto& l) { return l.Remap (*map); },
+                                          masks[i],
+                                          std::abs (v[i]), (v[i] < 0), false, b);
+            new_upset.mbdd = s;
+          }
+        }
+        return new_upset;
       }
 
+      // Adds delta to dimension i of s, and keeps the values that are at
+      // least budget.
       template <typename Flip>
       auto plus_one_dim (const meta_bdd& s, const Bdd& var, Flip flip,
                          const Bdd& all_other_zeros,
-                         value_type delta, bool neg, bool carry) const;
+                         value_type delta, bool neg, bool carry, value_type budget) const;
   };
 }
 
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <numeric>
 #include <vector>
 
 #include <utils/cache.hh>
@@ -16,14 +18,14 @@ namespace upset {
   auto upset_adhoc<mmbdd_t<Bdd, StateType>>::plus_one_dim (
     const meta_bdd& s, const Bdd& var, Flip flip,
     const Bdd& all_other_zeros,
-    value_type delta, bool neg, bool carry) const {
-#define local_args s, var, dim, delta, neg, carry
+    value_type delta, bool neg, bool carry, value_type budget) const {
+#define local_args s, var, dim, delta, neg, carry, budget
     static auto cache = utils::make_cache<std::pair<bool, meta_bdd>> (local_args);
     auto cached = cache.get (local_args);
     if (cached)
       return *cached;
 
-    if (delta == 0 and not carry)
+    if (delta == 0 and not carry and budget == 0)
       return cache (std::pair {s.accepts ({}), s}, local_args);
 
     transition_type trans;
@@ -31,46 +33,131 @@ namespace upset {
     bool b = delta & 1;
 
     for (auto&& [dest, labels] : s.neighbors ()) {
-      const auto dest_carry = [&] (bool carry, bool reaching_with_zero) {
-        if (delta == 0 and dest == s and carry) // self-loop waiting for carry
+      // Writing the bit o leaves (budget - o + 1) / 2 to reach.
+      const auto dest_carry = [&] (bool c, bool o, bool reaching_with_zero) {
+        auto next_budget = (budget - o + 1) >> 1;
+        if (delta == 0 and dest == s and c == carry and next_budget == budget) // self-loop waiting for carry or budget
           return mmbdd.self ();
-        auto&& [zr, mbdd] = plus_one_dim (dest, var, flip, all_other_zeros, delta >> 1, neg, carry);
+        auto&& [zr, mbdd] = plus_one_dim (dest, var, flip, all_other_zeros, delta >> 1, neg, c, next_budget);
         if (reaching_with_zero)
           zero_reach = zero_reach or zr;
         return mbdd;
       };
 
-      if (b and carry)     // + 2
-        trans += labels * dest_carry (true, not (labels * !var * all_other_zeros).isZero ()); // Labels are preserved
-      else if (b or carry) { // + 1
+      if (b != carry) { // + 1
         auto var_true =  labels *  var;
-        auto var_false = labels * !var;
+        auto var_false = labels.AndNot (var);
         if (not var_true.isZero ())
-          trans += flip (var_true) * dest_carry (not neg, not (all_other_zeros * var_true).isZero ());
+          trans += flip (var_true) * dest_carry (not neg, false, not (all_other_zeros * var_true).isZero ());
         if (not var_false.isZero ())
-          trans += flip (var_false) * dest_carry (neg, false);
+          trans += flip (var_false) * dest_carry (neg, true, false);
       }
-      else               // + 0
-        trans += labels * dest_carry (false, not (labels * !var * all_other_zeros).isZero ()); // Labels are preserved
+      else if (budget & 1) { // + 0 or + 2, labels are preserved and split by the budget
+        auto var_true =  labels *  var;
+        auto var_false = labels.AndNot (var);
+        if (not var_true.isZero ())
+          trans += var_true * dest_carry (carry, true, false);
+        if (not var_false.isZero ())
+          trans += var_false * dest_carry (carry, false, not (var_false * all_other_zeros).isZero ());
+      }
+      else               // + 0 or + 2, labels are preserved
+        trans += labels * dest_carry (carry, false, not (labels.AndNot (var) * all_other_zeros).isZero ());
     }
+    // The budget is not reached if the word stops here.
+    zero_reach = zero_reach and budget == 0;
     return cache (std::pair {zero_reach, mmbdd.make (trans, zero_reach)}, local_args);
+#undef local_args
   }
 
   template <typename Bdd, typename StateType>
   upset_adhoc<mmbdd_t<Bdd, StateType>>::upset_adhoc (master_meta_bdd& mmbdd,
                                          const std::vector<value_type>& v) :
     mmbdd {mmbdd}, mbdd {mmbdd.full ()}, dim {v.size ()} {
+    mbdd = up_mbdd (v);
+  }
+
+  template <typename Bdd, typename StateType>
+  upset_adhoc<mmbdd_t<Bdd, StateType>>::upset_adhoc (master_meta_bdd& mmbdd,
+                                         std::span<const std::vector<value_type>> vs) :
+    mmbdd {mmbdd}, mbdd {mmbdd.empty ()}, dim {0} {
+    assert (not vs.empty ());
+    dim = vs.front ().size ();
+
+    // Only the minimal elements matter.  In lexicographic order, a vector
+    // can only be dominated by vectors that come before it.
+    auto sorted = std::vector (vs.begin (), vs.end ());
+    std::ranges::sort (sorted);
+    auto mins = std::vector<std::vector<value_type>> ();
+    for (auto&& v : sorted)
+      if (std::ranges::none_of (mins, [&] (const auto& m) {
+        return std::ranges::equal (m, v, std::less_equal<> ());
+      }))
+        mins.push_back (std::move (v));
+    mbdd = up_mbdd (std::span<const std::vector<value_type>> (mins));
+  }
+
+  template <typename Bdd, typename StateType>
+  auto upset_adhoc<mmbdd_t<Bdd, StateType>>::pre_all (std::span<const std::vector<value_type>> deltas,
+                                                      std::span<const std::vector<value_type>> budgets) const
+    -> upset_adhoc {
+    assert (deltas.size () == budgets.size ());
+    // With the same delta, a larger budget gives fewer predecessors.  Sorted,
+    // a transition can only be subsumed by one that comes before it.
+    auto order = std::vector<size_t> (deltas.size ());
+    std::iota (order.begin (), order.end (), 0);
+    std::ranges::sort (order, [&] (size_t a, size_t b) {
+      return std::tie (deltas[a], budgets[a]) < std::tie (deltas[b], budgets[b]);
+    });
+    auto kept = std::vector<size_t> ();
+    for (auto t : order)
+      if (std::ranges::none_of (kept, [&] (size_t k) {
+        return deltas[k] == deltas[t] and std::ranges::equal (budgets[k], budgets[t], std::less_equal<> ());
+      }))
+        kept.push_back (t);
+
+    // The passes of transitions that agree on a dimension are shared
+    // through the cache of plus_one_dim.  In this order, transitions with the
+    // same delta are joined one after the other, as their predecessors
+    // overlap the most.
+    auto ret = upset_adhoc (mmbdd, dim);
+    for (auto t : kept)
+      ret |= pre (deltas[t], budgets[t]);
+    return ret;
+  }
+
+  template <typename Bdd, typename StateType>
+  auto upset_adhoc<mmbdd_t<Bdd, StateType>>::up_mbdd (const std::vector<value_type>& v) const -> meta_bdd {
     static auto cache = utils::make_cache<meta_bdd> (v);
     auto cached = cache.get (v);
-    if (cached) {
-      mbdd = *cached;
-      return;
-    }
+    if (cached)
+      return *cached;
 
-    for (size_t i = 0; i < dim; ++i)
-      mbdd = mbdd & up_mbdd_high_branch (v[i], i);
+    if (std::ranges::all_of (v, [] (value_type x) { return x == 0; }))
+      return cache (mmbdd.full (), v);
 
-    cache (mbdd, v);
+    // The vectors left to reach, with the letters that lead to them.  Only
+    // the odd values depend on the bit that is read.
+    auto succs = std::vector<std::pair<std::vector<value_type>, Bdd>> {{{}, Bdd::bddOne ()}};
+    for (size_t i = 0; i < v.size (); ++i) {
+      if (v[i] % 2 == 0) {
+        for (auto&& [w, _] : succs)
+          w.push_back (v[i] >> 1);
+        continue;
+      }
+      for (size_t j = 0, n = succs.size (); j < n; ++j) {
+        auto zero = succs[j];
+        zero.first.push_back ((v[i] + 1) >> 1);
+        zero.second *= !Bdd::bddVar (i);
+        succs[j].first.push_back (v[i] >> 1);
+        succs[j].second *= Bdd::bddVar (i);
+        succs.push_back (std::move (zero));
+      }
+    }
+
+    transition_type trans;
+    for (auto&& [w, label] : succs)
+      trans += label * (w == v ? mmbdd.self () : up_mbdd (w));
+    return cache (mmbdd.make (trans, false), v);
   }
 
   template <typename Bdd, typename StateType>
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <bit>
+
 #include <upset.hh>
 
 #include <meta_bdd_states_are_bddvars/meta_bdd.hh>
@@ -32,12 +34,20 @@ namespace upset {
         : mmbdd {mmbdd}, mbdd {m}, dim {d} {}
 
     public:
+      // The empty upset of dimension d.
+      upset (master_meta_bdd& mmbdd, size_t d)
+        : upset (mmbdd, mmbdd.empty (), d) {}
+
       upset (master_meta_bdd& mmbdd, const std::vector<value_type>& v);
 
       upset (master_meta_bdd& mmbdd,
              std::initializer_list<value_type> v) :
         upset (mmbdd, std::vector (v)) {}
 
+      // The upward closure of the nonempty set vs, built by balanced unions of
+      // its minimal elements rather than one vector at a time.
+      upset (master_meta_bdd& mmbdd, std::span<const std::vector<value_type>> vs);
+
       bool operator== (const upset& other) const {
         // Don't compare oranges and apples
         assert (&mmbdd == &other.mmbdd and dim == other.dim);
@@ -92,39 +102,24 @@ namespace upset {
       }
 
       upset operator+ (std::span<const value_type> v) const {
-        auto new_upset = *this;
-
-        for (size_t i = 0; i < dim; ++i) {
-          if (v[i] == 0)
-            continue;
+        return plus (v, {});
+      }
 
-          static auto self_trans_cache = utils::make_cache<Bdd> (dim, i);
-          auto st_cached = self_trans_cache.get (dim, i);
-          auto untouched = Bdd::bddOne ();
-          if (st_cached)
-            untouched = *st_cached;
-          else {
-            for (size_t idx = 0; idx < dim; ++idx) {
-              if (i == idx)
-                continue;
-              auto var = Bdd::bddVar (2 * idx);
-              auto var_mapped = Bdd::bddVar (2 * idx + 1);
-              untouched *= !(var ^ var_mapped);
-            }
-            self_trans_cache (untouched, dim, i);
-          }
-          std::cout << "Computing transduction..." << std::endl;
-          auto trans = plus_transducer_one_dim (i, dim, std::abs (v[i]), (v[i] < 0), 0, untouched);
-          std::cout << "Transducting..." << std::endl;
-          // Zero padding here can reduce the size of the mbdd, hence speed things up.
-          new_upset = new_upset.transduct (trans).full_zero_padded ();
-          std::cout << "Done dimension " << i << std::endl;
-        }
-        /* Alternatively, we could zero pad at the end.
-         std::cout << "Zero padding..." << std::endl;
-         auto pdd = new_upset.full_zero_padded (); */
-        return new_upset;
+      // The predecessors through a Petri transition, (*this + delta) &
+      // upset (budget), with each dimension shifted and raised to its budget
+      // by the same transduction.
+      upset pre (std::span<const value_type> delta, std::span<const value_type> budget) const {
+        assert (budget.size () == dim);
+        return plus (delta, budget);
       }
+      upset pre (const std::vector<value_type>& delta, const std::vector<value_type>& budget) const {
+        return pre (std::span (delta), std::span (budget));
+      }
+
+      // The union of the predecessors through each transition t, given by
+      // deltas[t] and budgets[t].
+      upset pre_all (std::span<const std::vector<value_type>> deltas,
+                     std::span<const std::vector<value_type>> budgets) const;
 
       upset& operator= (const upset& other) {
         assert (&mmbdd == &other.mmbdd);
@@ -136,25 +131,25 @@ namespace upset {
       upset& operator+= (std::span<const value_type> v) { return ((*this) = (*this) + v); }
       upset& operator+= (std::initializer_list<value_type> v) { return (operator+=) (std::span (v)); }
 
-      bool contains (std::span<const value_type> sv) const {
-        // Make a copy as we're going to shift all these values.
-        std::vector<value_type> v (sv.begin (), sv.end ());
-        std::vector<typename Bdd::letter_type> w;
-
+      bool contains (std::span<const value_type> v) const {
         assert (v.size () == dim);
-        bool is_zero = false;
-        while (not is_zero) {
-          is_zero = true;
-          typename Bdd::letter_type bits;
-          bits = Bdd::bddOne ();
-          for (size_t i = 0; i < dim; ++i) {
-            bits *= (v[i] % 2) ? Bdd::bddVar (2 * i) : !Bdd::bddVar (2 * i);
-            if ((v[i] >>= 1))
-              is_zero = false;
-          }
-          w.push_back (bits);
-        }
-        return mbdd.accepts (w);
+        // One letter per bit of the largest value, least significant first,
+        // and at least one.
+        size_t len = 1;
+        for (auto x : v)
+          len = std::max (len, (size_t) std::bit_width ((size_t) x));
+        return mbdd.accepts_valuations (len, [&] (size_t k, int var) {
+          return var % 2 == 0 and (size_t) var / 2 < dim and ((v[var / 2] >> k) & 1);
+        });
+      }
+
+      // The membership of each of vs, in order.
+      std::vector<bool> contains (std::span<const std::vector<value_type>> vs) const {
+        auto res = std::vector<bool> ();
+        res.reserve (vs.size ());
+        for (auto&& v : vs)
+          res.push_back (contains (v));
+        return res;
       }
 
       bool contains (std::initializer_list<value_type> v) const {
@@ -175,23 +170,15 @@ namespace upset {
       meta_bdd mbdd;
       size_t dim;
 
-      meta_bdd up_mbdd_high_branch (value_type value, size_t dim) {
-        if (value == 0)
-          return mmbdd.full ();
-        if (value % 2 == 1)
-          return mmbdd.make (Bdd::bddVar (2 * dim) * up_mbdd_high_branch (value >> 1, dim) +
-                             !Bdd::bddVar (2 * dim) * up_mbdd_low_branch (value >> 1, dim), false);
-        return mmbdd.make (Bdd::bddOne () * up_mbdd_high_branch (value >> 1, dim), false);
-      }
-
-      meta_bdd up_mbdd_low_branch (value_type value, size_t dim) {
-        if (value == 0)
-          return mmbdd.make (!Bdd::bddVar (2 * dim) * mmbdd.self () +
-                             Bdd::bddVar (2 * dim) * mmbdd.full (), false);
-        if (value % 2 == 0)
-          return mmbdd.make (Bdd::bddVar (2 * dim) * up_mbdd_high_branch (value >> 1, dim) +
-                             !Bdd::bddVar (2 * dim) * up_mbdd_low_branch (value >> 1, dim), false);
-        return mmbdd.make (Bdd::bddOne () * up_mbdd_low_branch (value >> 1, dim), false);
+      // The upward closure of v.  Reading the bits b of the least
+      // significant position leaves (v - b + 1) / 2 to reach, so the states
+      // are the vectors left to reach, each made once.
+      meta_bdd up_mbdd (const std::vector<value_type>& v) const;
+      meta_bdd up_mbdd (std::span<const std::vector<value_type>> vs) const {
+        if (vs.size () == 1)
+          return up_mbdd (vs.front ());
+        auto half = vs.size () / 2;
+        return up_mbdd (vs.first (half)) | up_mbdd (vs.subspan (half));
       }
 
       auto bit_identities (size_t nbits) const;
@@ -207,9 +194,48 @@ namespace upset {
         return upset (mmbdd, full_zero_padded (mbdd, all_zero), dim);
       }
 
+      // Adds v, then keeps the vectors above budget if it is nonempty.
+      upset plus (std::span<const value_type> v, std::span<const value_type> budget) const {
+        auto new_upset = *this;
+
+        for (size_t i = 0; i < dim; ++i) {
+          auto b = budget.empty () ? 0 : budget[i];
+          if (v[i] == 0 and b == 0)
+            continue;
+
+          static auto self_trans_cache = utils::make_cache<Bdd> (dim, i);
+          auto st_cached = self_trans_cache.get (dim, i);
+          auto untouched = Bdd::bddOne ();
+          if (st_cached)
+            untouched = *st_cached;
+          else {
+            for (size_t idx = 0; idx < dim; ++idx) {
+              if (i == idx)
+                continue;
+              auto var = Bdd::bddVar (2 * idx);
+              auto var_mapped = Bdd::bddVar (2 * idx + 1);
+              untouched *= !(var ^ var_mapped);
+            }
+            self_trans_cache (untouched, dim, i);
+          }
+          std::cout << "Computing transduction..." << std::endl;
+          auto trans = plus_transducer_one_dim (i, dim, std::abs (v[i]), (v[i] < 0), 0, b, untouched);
+          std::cout << "Transducting..." << std::endl;
+          // Zero padding here can reduce the size of the mbdd, hence speed things up.
+          new_upset = new_upset.transduct (trans).full_zero_padded ();
+          std::cout << "Done dimension " << i << std::endl;
+        }
+        /* Alternatively, we could zero pad at the end.
+         std::cout << "Zero padding..." << std::endl;
+         auto pdd = new_upset.full_zero_padded (); */
+        return new_upset;
+      }
+
+      // Adds delta to dimension idx, and keeps the values that are at least
+      // budget.
       auto plus_transducer_one_dim (size_t idx, size_t dim,
                                     value_type delta,
-                                    bool neg, bool carry,
+                                    bool neg, bool carry, value_type budget,
                                     Bdd untouched_components) const;
 
       auto plus_transducer (const std::vector<value_type>& delta,
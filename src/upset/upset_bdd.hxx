@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <numeric>
 #include <vector>
 
 #include <utils/cache.hh>
@@ -33,14 +35,14 @@ namespace upset {
   // Maybe todo: see if we can restrict to just a few dimensions
   template <typename Bdd, typename StateType>
   auto upset<mmbdd_t<Bdd, StateType>>::full_zero_padded (const meta_bdd& s, Bdd all_zero) const {
-    static auto cache = utils::make_cache<meta_bdd, typename master_meta_bdd::state_t, int> ();
+    static auto cache = utils::make_cache<meta_bdd, typename master_meta_bdd::state_t, Bdd> ();
 
-    auto cached = cache.get (s, all_zero.GetBDD ());
+    auto cached = cache.get (s, all_zero);
     if (cached)
       return *cached;
 
     if (s == mmbdd.full () or s == mmbdd.empty ())
-      return cache (s, s, all_zero.GetBDD ());
+      return cache (s, s, all_zero);
 
     bool should_be_accepting = s.accepts ({}), zero_seen = false;
     auto to_make = transition_type ();
@@ -58,50 +60,50 @@ namespace upset {
         to_make += labels * new_dest;
       }
     }
-    return cache (mmbdd.make (to_make, should_be_accepting), s, all_zero.GetBDD ());
+    return cache (mmbdd.make (to_make, should_be_accepting), s, all_zero);
   }
 
     template <typename Bdd, typename StateType>
     auto upset<mmbdd_t<Bdd, StateType>>::plus_transducer_one_dim (size_t idx, size_t dim,
                                                                   upset::value_type delta,
                                                                   bool neg, bool carry,
+                                                                  upset::value_type budget,
                                                                   Bdd untouched_components) const {
-#define local_args idx, dim, delta, neg, carry
+#define local_args idx, dim, delta, neg, carry, budget
     static auto cache = utils::make_cache<meta_bdd> (local_args);
     auto cached = cache.get (local_args);
     if (cached)
       return *cached;
 
-    if (delta == 0 and carry == 0)
+    if (delta == 0 and carry == 0 and budget == 0)
       return cache (bit_identities (dim), local_args);
 
+    // The output is always the odd variable, whichever way the addition goes.
+    auto written = Bdd::bddVar (2 * idx + 1);
     auto var = Bdd::bddVar (2 * idx);
-    auto var_mapped = Bdd::bddVar (2 * idx + 1);
+    auto var_mapped = written;
     if (neg)
       std::swap (var, var_mapped);
     bool b = delta & 1;
 
-    auto dest_nocarry = mmbdd.full (), dest_carry = mmbdd.full ();
-    if (delta == 0) {
-      assert (carry);
-      dest_nocarry = plus_transducer_one_dim (idx, dim, 0, neg, false, untouched_components);
-      dest_carry = mmbdd.self ();
-    }
-    else {
-      if (not (b and carry)) /* otherwise, a carry must be generated */
-        dest_nocarry = plus_transducer_one_dim (idx, dim, delta >> 1, neg, false, untouched_components);
-      if (b or carry) /* otherwise, no carry can be generated */
-        dest_carry = plus_transducer_one_dim (idx, dim, delta >> 1, neg, true, untouched_components);
-    }
+    // Writing the bit o leaves (budget - o + 1) / 2 to reach.
+    auto dest = [&] (bool c, bool o) {
+      auto next_budget = (budget - o + 1) >> 1;
+      if (delta == 0 and c == carry and next_budget == budget) // waiting for carry or budget
+        return mmbdd.self ();
+      return plus_transducer_one_dim (idx, dim, delta >> 1, neg, c, next_budget, untouched_components);
+    };
 
     transition_type trans;
-    if (b and carry)     // + 2
-      trans = !(var ^ var_mapped) * untouched_components * dest_carry;
-    else if (b or carry) // + 1
-      trans = var * !var_mapped * untouched_components * dest_carry +
-        !var * var_mapped * untouched_components * dest_nocarry;
-    else                 // + 0
-      trans = !(var ^ var_mapped) * untouched_components * dest_nocarry;
+    if (b != carry)      // + 1
+      trans = var.AndNot (var_mapped) * untouched_components * dest (true, neg) +
+        var_mapped.AndNot (var) * untouched_components * dest (false, not neg);
+    else if (budget & 1) { // + 0 or + 2, split by the budget
+      auto same = var.Xnor (var_mapped) * untouched_components;
+      trans = same * written * dest (carry, true) + same * !written * dest (carry, false);
+    }
+    else                 // + 0 or + 2
+      trans = var.Xnor (var_mapped) * untouched_components * dest (carry, false);
 
     return cache (mmbdd.make (trans, false), local_args);
 #undef local_args
@@ -118,129 +120,52 @@ namespace upset {
     if (cached)
       return *cached;
 
-    // Main algo
     auto size = delta.size ();
-    auto delta_shifted = std::vector<upset::value_type> (size);
-    transition_type full_trans;
-    bool all_zero_delta = true, all_zero_carries = true;
-
-    for (size_t i = 0; i < size; ++i) {
-      delta_shifted[i] = delta[i] >> 1;
-      if (delta[i])
-        all_zero_delta = false;
-      if (carries[i])
-        all_zero_carries = false;
-    }
-
-    if (all_zero_delta and all_zero_carries) // Stopping condition.
+    if (std::ranges::all_of (delta, [] (auto d) { return d == 0; }) and
+        std::ranges::none_of (carries, std::identity ())) // Stopping condition.
       return cache (bit_identities (size), delta, neg, carries);
 
+    // Each dimension adds k = (delta & 1) + carry to its bit.  For k = 0 or
+    // 2, the bit is kept and the next carry is known.  For k = 1, the bit
+    // flips and carries if it was 1.  The labels are the conjunctions of the
+    // relation of each dimension, and only the dimensions with k = 1 split
+    // them, into the carry vectors they lead to.
+    auto delta_shifted = std::vector<upset::value_type> (size);
     auto new_carries = std::vector<bool> (size);
-    size_t to = 1 << size;
-
-    if (all_zero_delta) { // Nothing more to add, but carries need to be propagated.
-      for (size_t x = 0; x < to; ++x) {
-        auto n = x;
-        auto trans = Bdd::bddOne ();
-        bool at_least_one_carry_consummed = false;
-
-        for (size_t i = 0; i < size; ++i) {
-          auto var = Bdd::bddVar (2 * i);
-          auto var_mapped = Bdd::bddVar (2 * i + 1);
-          if (neg[i])
-            std::swap (var, var_mapped);
-          bool b = n & 1;
-          n >>= 1;
-
-          if (b) {
-            if (carries[i]) { // 1 and carry
-              trans *= var * !var_mapped; // 1 -> 0
-              new_carries[i] = true;
-            }
-            else { // 1 and no carry
-              trans *= var * var_mapped; // 1 -> 1
-              new_carries[i] = false;
-            }
-          }
-          else {
-            if (carries[i]) { // 0 and carry
-              trans *= !var * var_mapped; // 0 -> 1
-              new_carries[i] = false;
-              at_least_one_carry_consummed = true;
-            }
-            else { // 0 and no carry
-              trans *= !var * !var_mapped;
-              new_carries[i] = false;
-            }
-          }
-        }
-        if (at_least_one_carry_consummed)
-          full_trans += trans * plus_transducer (delta, neg, new_carries);
-        else
-          full_trans += trans * mmbdd.self ();
+    auto kept = Bdd::bddOne ();
+    auto split = std::vector<size_t> ();
+    for (size_t i = 0; i < size; ++i) {
+      delta_shifted[i] = delta[i] >> 1;
+      auto k = (delta[i] & 1) + carries[i];
+      if (k == 1) {
+        split.push_back (i);
+        continue;
       }
-      return cache (mmbdd.make (full_trans, false), delta, neg, carries);
+      kept *= !(Bdd::bddVar (2 * i) ^ Bdd::bddVar (2 * i + 1));
+      new_carries[i] = (k == 2);
     }
 
-    for (size_t x = 0; x < to; ++x) {
-      auto n = x;
-      auto trans = Bdd::bddOne ();
-
-      for (size_t i = 0; i < size; ++i) {
-        auto var = Bdd::bddVar (2 * i);
-        auto var_mapped = Bdd::bddVar (2 * i + 1);
-        if (neg[i])
-          std::swap (var, var_mapped);
-        bool b = n & 1;
-        n >>= 1;
-
-        if (b) {
-          if (delta[i] & 1) { // 1 and +1
-            if (carries[i]) { // 1 and +1 and carry
-              trans *= var * var_mapped; // 1 -> 1
-              new_carries[i] = true;
-            }
-            else { // 1 and +1 and no carry
-              trans *= var * !var_mapped; // 1 -> 0
-              new_carries[i] = true;
-            }
-          }
-          else { // 1 and +0
-            if (carries[i]) { // 1 and + 0 and carry
-              trans *= var * !var_mapped; // 1 -> 0
-              new_carries[i] = true;
-            }
-            else { // 1 and +0 and no carry
-              trans *= var * var_mapped; // 1 -> 1
-              new_carries[i] = false;
-            }
-          }
-        }
-        else {
-          if (delta[i] & 1) { // 0 and + 1
-            if (carries[i]) { // 0 and + 1 and carry
-              trans *= !var * !var_mapped; // 0 -> 0
-              new_carries[i] = true;
-            }
-            else { // 0 and +1 and no carry
-              trans *= !var * var_mapped; // 0 -> 1
-              new_carries[i] = false;
-            }
-          }
-          else { // 0 and +0
-            if (carries[i]) { // 0 and +0 and carry
-              trans *= !var * var_mapped; // 0 -> 1
-              new_carries[i] = false;
-            }
-            else { // 0 and +0 and no carry
-              trans *= !var * !var_mapped; // 0 -> 0
-              new_carries[i] = false;
-            }
-          }
-        }
+    auto succs = std::vector<std::pair<std::vector<bool>, Bdd>> {{new_carries, kept}};
+    for (auto i : split) {
+      auto var = Bdd::bddVar (2 * i);
+      auto var_mapped = Bdd::bddVar (2 * i + 1);
+      if (neg[i])
+        std::swap (var, var_mapped);
+      for (size_t j = 0, n = succs.size (); j < n; ++j) {
+        auto no_carry = succs[j];
+        no_carry.second *= !var * var_mapped; // 0 -> 1
+        succs[j].first[i] = true;
+        succs[j].second *= var * !var_mapped; // 1 -> 0
+        succs.push_back (std::move (no_carry));
       }
-      full_trans += trans * plus_transducer (delta_shifted, neg, new_carries);
     }
+
+    // Once delta is consumed, reading letters that keep all the carries
+    // loops.
+    transition_type full_trans;
+    for (auto&& [c, label] : succs)
+      full_trans += label * (delta_shifted == delta and c == carries ?
+                             mmbdd.self () : plus_transducer (delta_shifted, neg, c));
     return cache (mmbdd.make (full_trans, false), delta, neg, carries);
   }
 
@@ -248,17 +173,91 @@ namespace upset {
   upset<mmbdd_t<Bdd, StateType>>::upset (master_meta_bdd& mmbdd,
                                          const std::vector<value_type>& v) :
     mmbdd {mmbdd}, mbdd {mmbdd.full ()}, dim {v.size ()} {
+    mbdd = up_mbdd (v);
+  }
+
+  template <typename Bdd, typename StateType>
+  upset<mmbdd_t<Bdd, StateType>>::upset (master_meta_bdd& mmbdd,
+                                         std::span<const std::vector<value_type>> vs) :
+    mmbdd {mmbdd}, mbdd {mmbdd.empty ()}, dim {0} {
+    assert (not vs.empty ());
+    dim = vs.front ().size ();
+
+    // Only the minimal elements matter.  In lexicographic order, a vector
+    // can only be dominated by vectors that come before it.
+    auto sorted = std::vector (vs.begin (), vs.end ());
+    std::ranges::sort (sorted);
+    auto mins = std::vector<std::vector<value_type>> ();
+    for (auto&& v : sorted)
+      if (std::ranges::none_of (mins, [&] (const auto& m) {
+        return std::ranges::equal (m, v, std::less_equal<> ());
+      }))
+        mins.push_back (std::move (v));
+    mbdd = up_mbdd (std::span<const std::vector<value_type>> (mins));
+  }
+
+  template <typename Bdd, typename StateType>
+  auto upset<mmbdd_t<Bdd, StateType>>::pre_all (std::span<const std::vector<value_type>> deltas,
+                                                std::span<const std::vector<value_type>> budgets) const
+    -> upset {
+    assert (deltas.size () == budgets.size ());
+    // With the same delta, a larger budget gives fewer predecessors.  Sorted,
+    // a transition can only be subsumed by one that comes before it.
+    auto order = std::vector<size_t> (deltas.size ());
+    std::iota (order.begin (), order.end (), 0);
+    std::ranges::sort (order, [&] (size_t a, size_t b) {
+      return std::tie (deltas[a], budgets[a]) < std::tie (deltas[b], budgets[b]);
+    });
+    auto kept = std::vector<size_t> ();
+    for (auto t : order)
+      if (std::ranges::none_of (kept, [&] (size_t k) {
+        return deltas[k] == deltas[t] and std::ranges::equal (budgets[k], budgets[t], std::less_equal<> ());
+      }))
+        kept.push_back (t);
+
+    // The transducers of transitions that agree on a dimension are shared
+    // through the cache of plus_transducer_one_dim.  In this order,
+    // transitions with the same delta are joined one after the other, as
+    // their predecessors overlap the most.
+    auto ret = upset (mmbdd, dim);
+    for (auto t : kept)
+      ret |= pre (deltas[t], budgets[t]);
+    return ret;
+  }
+
+  template <typename Bdd, typename StateType>
+  auto upset<mmbdd_t<Bdd, StateType>>::up_mbdd (const std::vector<value_type>& v) const -> meta_bdd {
     static auto cache = utils::make_cache<meta_bdd> (v);
     auto cached = cache.get (v);
-    if (cached) {
-      mbdd = *cached;
-      return;
-    }
+    if (cached)
+      return *cached;
 
-    for (size_t i = 0; i < dim; ++i)
-      mbdd = mbdd & up_mbdd_high_branch (v[i], i);
+    if (std::ranges::all_of (v, [] (value_type x) { return x == 0; }))
+      return cache (mmbdd.full (), v);
 
-    cache (mbdd, v);
+    // The vectors left to reach, with the letters that lead to them.  Only
+    // the odd values depend on the bit that is read.
+    auto succs = std::vector<std::pair<std::vector<value_type>, Bdd>> {{{}, Bdd::bddOne ()}};
+    for (size_t i = 0; i < v.size (); ++i) {
+      if (v[i] % 2 == 0) {
+        for (auto&& [w, _] : succs)
+          w.push_back (v[i] >> 1);
+        continue;
+      }
+      for (size_t j = 0, n = succs.size (); j < n; ++j) {
+        auto zero = succs[j];
+        zero.first.push_back ((v[i] + 1) >> 1);
+        zero.second *= !Bdd::bddVar (2 * i);
+        succs[j].first.push_back (v[i] >> 1);
+        succs[j].second *= Bdd::bddVar (2 * i);
+        succs.push_back (std::move (zero));
+      }
+    }
+
+    transition_type trans;
+    for (auto&& [w, label] : succs)
+      trans += label * (w == v ? mmbdd.self () : up_mbdd (w));
+    return cache (mmbdd.make (trans, false), v);
   }
 
   template <typename Bdd, typename StateType>
@@ -8,7 +8,7 @@
 #include "abcbdd.hh"
 namespace utils {
   namespace detail {
-    Abc_BddMan* global_bddman;
+    thread_local Abc_BddMan* global_bddman;
 
     Abc_BddMan * Abc_BddManAlloc( int nVars, int nObjs )
     {
@@ -20,21 +20,90 @@ namespace utils {
       p->nCacheMask  = (1 << Abc_Base2Log(nObjs)) - 1;
       p->pUnique     = ABC_CALLOC( int, p->nUniqueMask + 1 );
       p->pNexts      = ABC_CALLOC( int, p->nObjsAlloc );
-      p->pCache      = ABC_CALLOC( int, 3*(p->nCacheMask + 1) );
+      p->pCache      = ABC_CALLOC( int, ABC_BDD_CACHE_ENTRY*(p->nCacheMask + 1) );
       p->pObjs       = ABC_CALLOC( int, 2*p->nObjsAlloc );
       p->pMark       = ABC_CALLOC( unsigned char, p->nObjsAlloc );
-      p->pVars       = ABC_CALLOC( unsigned char, p->nObjsAlloc );
-      p->pVars[0]    = 0xff;
+      p->pRefs       = ABC_CALLOC( int, p->nObjsAlloc );
+      p->pVars       = ABC_CALLOC( int, p->nObjsAlloc );
+      p->pVars[0]    = ABC_BDD_CONST_VAR;
       p->nObjs       = 1;
       for ( i = 0; i < nVars; i++ )
         Abc_BddUniqueCreate( p, i, 1, 0 );
       assert( p->nObjs == nVars + 1 );
       p->nMemory = sizeof(Abc_BddMan)/4 +
         p->nUniqueMask + 1 + p->nObjsAlloc +
-        (p->nCacheMask + 1) * 3 * sizeof(int)/4 +
+        (p->nCacheMask + 1) * ABC_BDD_CACHE_ENTRY * sizeof(int)/4 +
         p->nObjsAlloc * 2 * sizeof(int)/4;
       return p;
     }
+
+    /**Function*************************************************************
+
+     Synopsis    [Rebuilds the unique table from the nodes not in the free list.]
+
+     Description [The chains are ordered by node index.]
+
+     SideEffects []
+
+     SeeAlso     []
+
+     ***********************************************************************/
+    static void Abc_BddManRehash( Abc_BddMan * p )
+    {
+      int i;
+      memset( p->pUnique, 0, sizeof(int) * (p->nUniqueMask + 1) );
+      for ( i = 1; i < p->nObjs; i++ )
+      {
+        if ( p->pVars[i] < 0 ) // free
+          continue;
+        int *q = p->pUnique + (Abc_BddHash(p->pVars[i], p->pObjs[i+i], p->pObjs[i+i+1]) & p->nUniqueMask);
+        for ( ; *q; q = p->pNexts + *q );
+        *q = i;
+        p->pNexts[i] = 0;
+      }
+    }
+
+    /**Function*************************************************************
+
+     Synopsis    [Doubles the node arrays, the unique table and the cache.]
+
+     Description [Nodes are not moved, only the unique table is rehashed.
+                  The cache is emptied.]
+
+     SideEffects []
+
+     SeeAlso     []
+
+     ***********************************************************************/
+    void Abc_BddManGrow( Abc_BddMan * p )
+    {
+      int nObjsAlloc = 2 * p->nObjsAlloc;
+      p->pNexts = ABC_REALLOC( int, p->pNexts, nObjsAlloc );
+      p->pObjs  = ABC_REALLOC( int, p->pObjs, 2 * nObjsAlloc );
+      p->pMark  = ABC_REALLOC( unsigned char, p->pMark, nObjsAlloc );
+      p->pVars  = ABC_REALLOC( int, p->pVars, nObjsAlloc );
+      p->pRefs  = ABC_REALLOC( int, p->pRefs, nObjsAlloc );
+      if ( !p->pNexts || !p->pObjs || !p->pMark || !p->pVars || !p->pRefs )
+        printf( "Aborting because %d nodes could not be allocated.\n", nObjsAlloc ), fflush(stdout), abort();
+      memset( p->pMark + p->nObjsAlloc, 0, nObjsAlloc - p->nObjsAlloc );
+      memset( p->pNexts + p->nObjsAlloc, 0, sizeof(int) * (nObjsAlloc - p->nObjsAlloc) );
+      memset( p->pRefs + p->nObjsAlloc, 0, sizeof(int) * (nObjsAlloc - p->nObjsAlloc) );
+      p->nObjsAlloc = nObjsAlloc;
+
+      p->nUniqueMask = (1 << Abc_Base2Log(nObjsAlloc)) - 1;
+      ABC_FREE( p->pUnique );
+      p->pUnique = ABC_CALLOC( int, p->nUniqueMask + 1 );
+      Abc_BddManRehash( p );
+
+      p->nCacheMask = (1 << Abc_Base2Log(nObjsAlloc)) - 1;
+      ABC_FREE( p->pCache );
+      p->pCache = ABC_CALLOC( int, ABC_BDD_CACHE_ENTRY*(p->nCacheMask + 1) );
+
+      p->nMemory = sizeof(Abc_BddMan)/4 +
+        p->nUniqueMask + 1 + p->nObjsAlloc +
+        (p->nCacheMask + 1) * ABC_BDD_CACHE_ENTRY * sizeof(int)/4 +
+        p->nObjsAlloc * 2 * sizeof(int)/4;
+    }
     void Abc_BddManFree( Abc_BddMan * p )
     {
       printf( "BDD stats: Var = %d  Obj = %d  Alloc = %d  Hit = %d  Miss = %d  ",
@@ -45,6 +114,8 @@ namespace utils {
       ABC_FREE( p->pCache );
       ABC_FREE( p->pObjs );
       ABC_FREE( p->pVars );
+      ABC_FREE( p->pMark );
+      ABC_FREE( p->pRefs );
       ABC_FREE( p );
     }
 
@@ -68,7 +139,7 @@ namespace utils {
       if ( b == 1 ) return a;
       if ( a == b ) return a;
       if ( a > b )  return Abc_BddAnd( p, b, a );
-      if ( (r = Abc_BddCacheLookup(p, a, b)) >= 0 )
+      if ( (r = Abc_BddCacheLookup(p, ABC_BDD_OP_AND, a, b, 0)) >= 0 )
         return r;
       if ( Abc_BddVar(p, a) < Abc_BddVar(p, b) )
         r0 = Abc_BddAnd( p, Abc_BddElse(p, a), b ),
@@ -80,7 +151,7 @@ namespace utils {
         r0 = Abc_BddAnd( p, Abc_BddElse(p, a), Abc_BddElse(p, b) ),
           r1 = Abc_BddAnd( p, Abc_BddThen(p, a), Abc_BddThen(p, b) );
       r = Abc_BddUniqueCreate( p, Abc_MinInt(Abc_BddVar(p, a), Abc_BddVar(p, b)), r1, r0 );
-      return Abc_BddCacheInsert( p, a, b, r );
+      return Abc_BddCacheInsert( p, ABC_BDD_OP_AND, a, b, 0, r );
     }
 
     int Abc_BddOr( Abc_BddMan * p, int a, int b )
@@ -88,6 +159,299 @@ namespace utils {
       return Abc_LitNot( Abc_BddAnd(p, Abc_LitNot(a), Abc_LitNot(b)) );
     }
 
+    // The cofactor of a with respect to Var, which is at or above its top variable.
+    static inline int Abc_BddCof( Abc_BddMan * p, int a, int Var, int fThen )
+    {
+      if ( Abc_BddVar(p, a) != Var )
+        return a;
+      return fThen ? Abc_BddThen(p, a) : Abc_BddElse(p, a);
+    }
+
+    /**Function*************************************************************
+
+     Synopsis    [Boolean XOR.]
+
+     Description [The complements are taken out of the arguments, so that
+                  the cache only holds regular pairs.]
+
+     SideEffects []
+
+     SeeAlso     []
+
+     ***********************************************************************/
+    int Abc_BddXor( Abc_BddMan * p, int a, int b )
+    {
+      int r0, r1, r, v, fCompl;
+      if ( a == b ) return 0;
+      if ( a == Abc_LitNot(b) ) return 1;
+      if ( a < 2 ) return Abc_LitNotCond( b, a );
+      if ( b < 2 ) return Abc_LitNotCond( a, b );
+      fCompl = Abc_LitIsCompl(a) ^ Abc_LitIsCompl(b);
+      a = Abc_LitRegular(a);
+      b = Abc_LitRegular(b);
+      if ( a > b )
+        r = a, a = b, b = r;
+      if ( (r = Abc_BddCacheLookup(p, ABC_BDD_OP_XOR, a, b, 0)) < 0 )
+      {
+        v = Abc_MinInt( Abc_BddVar(p, a), Abc_BddVar(p, b) );
+        r0 = Abc_BddXor( p, Abc_BddCof(p, a, v, 0), Abc_BddCof(p, b, v, 0) );
+        r1 = Abc_BddXor( p, Abc_BddCof(p, a, v, 1), Abc_BddCof(p, b, v, 1) );
+        r = Abc_BddCacheInsert( p, ABC_BDD_OP_XOR, a, b, 0, Abc_BddUniqueCreate(p, v, r1, r0) );
+      }
+      return Abc_LitNotCond( r, fCompl );
+    }
+
+    /**Function*************************************************************
+
+     Synopsis    [If-then-else.]
+
+     Description [Computes (f & g) | (!f & h).  The cases that reduce to a
+                  binary operation are delegated, and f and g are made
+                  regular before the cache lookup.]
+
+     SideEffects []
+
+     SeeAlso     []
+
+     ***********************************************************************/
+    int Abc_BddIte( Abc_BddMan * p, int f, int g, int h )
+    {
+      int r0, r1, r, v, fCompl;
+      if ( f == 1 ) return g;
+      if ( f == 0 ) return h;
+      if ( g == h ) return g;
+      if ( g == 1 || g == f ) return Abc_BddOr( p, f, h );
+      if ( g == 0 || g == Abc_LitNot(f) ) return Abc_BddAnd( p, Abc_LitNot(f), h );
+      if ( h == 0 || h == f ) return Abc_BddAnd( p, f, g );
+      if ( h == 1 || h == Abc_LitNot(f) ) return Abc_BddOr( p, Abc_LitNot(f), g );
+      if ( g == Abc_LitNot(h) ) return Abc_LitNot( Abc_BddXor(p, f, g) );
+      if ( Abc_LitIsCompl(f) )
+        f = Abc_LitNot(f), r = g, g = h, h = r;
+      fCompl = Abc_LitIsCompl(g);
+      g = Abc_LitNotCond( g, fCompl );
+      h = Abc_LitNotCond( h, fCompl );
+      if ( (r = Abc_BddCacheLookup(p, ABC_BDD_OP_ITE, f, g, h)) < 0 )
+      {
+        v = Abc_MinInt( Abc_BddVar(p, f), Abc_MinInt(Abc_BddVar(p, g), Abc_BddVar(p, h)) );
+        r0 = Abc_BddIte( p, Abc_BddCof(p, f, v, 0), Abc_BddCof(p, g, v, 0), Abc_BddCof(p, h, v, 0) );
+        r1 = Abc_BddIte( p, Abc_BddCof(p, f, v, 1), Abc_BddCof(p, g, v, 1), Abc_BddCof(p, h, v, 1) );
+        r = Abc_BddCacheInsert( p, ABC_BDD_OP_ITE, f, g, h, Abc_BddUniqueCreate(p, v, r1, r0) );
+      }
+      return Abc_LitNotCond( r, fCompl );
+    }
+
+    /**Function*************************************************************
+
+     Synopsis    [Existential and universal quantification.]
+
+     Description [The variables are given as a cube, a conjunction of
+                  positive literals.]
+
+     SideEffects []
+
+     SeeAlso     []
+
+     ***********************************************************************/
+    static int Abc_BddQuantify( Abc_BddMan * p, int a, int Cube, int fExist )
+    {
+      int r0, r1, r, v, Op = fExist ? ABC_BDD_OP_EXIST : ABC_BDD_OP_FORALL;
+      if ( a < 2 )
+        return a;
+      v = Abc_BddVar(p, a);
+      while ( Cube != 1 && Abc_BddVar(p, Cube) < v )
+        Cube = Abc_BddThen(p, Cube);
+      if ( Cube == 1 )
+        return a;
+      assert( Abc_BddElse(p, Cube) == 0 );
+      if ( (r = Abc_BddCacheLookup(p, Op, a, Cube, 0)) >= 0 )
+        return r;
+      if ( Abc_BddVar(p, Cube) == v )
+      {
+        // The result absorbs: no need for the other cofactor.
+        r0 = Abc_BddQuantify( p, Abc_BddElse(p, a), Abc_BddThen(p, Cube), fExist );
+        if ( r0 == fExist )
+          r = r0;
+        else
+        {
+          r1 = Abc_BddQuantify( p, Abc_BddThen(p, a), Abc_BddThen(p, Cube), fExist );
+          r = fExist ? Abc_BddOr( p, r0, r1 ) : Abc_BddAnd( p, r0, r1 );
+        }
+      }
+      else
+      {
+        r0 = Abc_BddQuantify( p, Abc_BddElse(p, a), Cube, fExist );
+        r1 = Abc_BddQuantify( p, Abc_BddThen(p, a), Cube, fExist );
+        r = Abc_BddUniqueCreate( p, v, r1, r0 );
+      }
+      return Abc_BddCacheInsert( p, Op, a, Cube, 0, r );
+    }
+
+    int Abc_BddExist( Abc_BddMan * p, int a, int Cube )
+    {
+      return Abc_BddQuantify( p, a, Cube, 1 );
+    }
+
+    int Abc_BddForall( Abc_BddMan * p, int a, int Cube )
+    {
+      return Abc_BddQuantify( p, a, Cube, 0 );
+    }
+
+    /**Function*************************************************************
+
+     Synopsis    [Existential quantification of a conjunction.]
+
+     Description [Computes Exist(a & b, Cube) without building a & b.]
+
+     SideEffects []
+
+     SeeAlso     []
+
+     ***********************************************************************/
+    int Abc_BddAndExist( Abc_BddMan * p, int a, int b, int Cube )
+    {
+      int r0, r1, r, v, fQuant;
+      if ( a == 0 || b == 0 || a == Abc_LitNot(b) ) return 0;
+      if ( a == 1 || a == b ) return Abc_BddExist( p, b, Cube );
+      if ( b == 1 ) return Abc_BddExist( p, a, Cube );
+      if ( a > b )
+        r = a, a = b, b = r;
+      v = Abc_MinInt( Abc_BddVar(p, a), Abc_BddVar(p, b) );
+      while ( Cube != 1 && Abc_BddVar(p, Cube) < v )
+        Cube = Abc_BddThen(p, Cube);
+      if ( Cube == 1 )
+        return Abc_BddAnd( p, a, b );
+      if ( (r = Abc_BddCacheLookup(p, ABC_BDD_OP_AND_EXIST, a, b, Cube)) >= 0 )
+        return r;
+      fQuant = Abc_BddVar(p, Cube) == v;
+      r0 = Abc_BddAndExist( p, Abc_BddCof(p, a, v, 0), Abc_BddCof(p, b, v, 0), fQuant ? Abc_BddThen(p, Cube) : Cube );
+      if ( fQuant && r0 == 1 )
+        r = 1;
+      else
+      {
+        r1 = Abc_BddAndExist( p, Abc_BddCof(p, a, v, 1), Abc_BddCof(p, b, v, 1), fQuant ? Abc_BddThen(p, Cube) : Cube );
+        r = fQuant ? Abc_BddOr( p, r0, r1 ) : Abc_BddUniqueCreate( p, v, r1, r0 );
+      }
+      return Abc_BddCacheInsert( p, ABC_BDD_OP_AND_EXIST, a, b, Cube, r );
+    }
+
+    /**Function*************************************************************
+
+     Synopsis    [Simultaneous substitution of variables by functions.]
+
+     Description [Variable i < nMap is replaced by pMap[i], the others are
+                  kept.  MapId identifies pMap in the cache, and should be
+                  obtained from Abc_BddManNewMapId.]
+
+     SideEffects []
+
+     SeeAlso     []
+
+     ***********************************************************************/
+    int Abc_BddCompose( Abc_BddMan * p, int a, const int * pMap, int nMap, int MapId )
+    {
+      int r0, r1, r, v;
+      if ( a < 2 )
+        return a;
+      if ( Abc_LitIsCompl(a) )
+        return Abc_LitNot( Abc_BddCompose(p, Abc_LitNot(a), pMap, nMap, MapId) );
+      if ( (r = Abc_BddCacheLookup(p, ABC_BDD_OP_COMPOSE, a, MapId, 0)) >= 0 )
+        return r;
+      v = Abc_BddVar(p, a);
+      r0 = Abc_BddCompose( p, Abc_BddElse(p, a), pMap, nMap, MapId );
+      r1 = Abc_BddCompose( p, Abc_BddThen(p, a), pMap, nMap, MapId );
+      r = Abc_BddIte( p, v < nMap ? pMap[v] : Abc_BddIthVar(v), r1, r0 );
+      return Abc_BddCacheInsert( p, ABC_BDD_OP_COMPOSE, a, MapId, 0, r );
+    }
+
+    /**Function*************************************************************
+
+     Synopsis    [Copies a BDD to another manager.]
+
+     Description [The variables keep their index, so pTo needs at least as
+                  many variables as the support of a.]
+
+     SideEffects []
+
+     SeeAlso     []
+
+     ***********************************************************************/
+    static int Abc_BddTransfer_rec( Abc_BddMan * pFrom, Abc_BddMan * pTo, int a, int * pCopy )
+    {
+      int r0, r1, i;
+      if ( a < 2 )
+        return a;
+      i = Abc_Lit2Var(a);
+      if ( pCopy[i] < 0 )
+      {
+        assert( Abc_BddVar(pFrom, a) < pTo->nVars );
+        r0 = Abc_BddTransfer_rec( pFrom, pTo, Abc_BddElse(pFrom, Abc_LitRegular(a)), pCopy );
+        r1 = Abc_BddTransfer_rec( pFrom, pTo, Abc_BddThen(pFrom, Abc_LitRegular(a)), pCopy );
+        pCopy[i] = Abc_BddUniqueCreate( pTo, Abc_BddVar(pFrom, a), r1, r0 );
+      }
+      return Abc_LitNotCond( pCopy[i], Abc_LitIsCompl(a) );
+    }
+
+    int Abc_BddTransfer( Abc_BddMan * pFrom, Abc_BddMan * pTo, int a )
+    {
+      int * pCopy, r;
+      if ( pFrom == pTo || a < 2 )
+        return a;
+      pCopy = ABC_FALLOC( int, pFrom->nObjs );
+      r = Abc_BddTransfer_rec( pFrom, pTo, a, pCopy );
+      ABC_FREE( pCopy );
+      return r;
+    }
+
+    /**Function*************************************************************
+
+     Synopsis    [Garbage collection.]
+
+     Description [Marks the variables and the nodes reachable from referenced
+                  nodes, puts the others in the free list, and empties the
+                  cache, which may refer to freed nodes.  Nodes are not
+                  moved.]
+
+     SideEffects []
+
+     SeeAlso     []
+
+     ***********************************************************************/
+    static void Abc_BddManMark_rec( Abc_BddMan * p, int i )
+    {
+      if ( p->pMark[i] )
+        return;
+      p->pMark[i] = 1;
+      Abc_BddManMark_rec( p, Abc_Lit2Var(p->pObjs[i+i]) );
+      Abc_BddManMark_rec( p, Abc_Lit2Var(p->pObjs[i+i+1]) );
+    }
+
+    void Abc_BddManGc( Abc_BddMan * p )
+    {
+      int i;
+      p->pMark[0] = 1;
+      for ( i = 1; i <= p->nVars; i++ )
+        Abc_BddManMark_rec( p, i );
+      for ( i = p->nVars + 1; i < p->nObjs; i++ )
+        if ( p->pRefs[i] )
+          Abc_BddManMark_rec( p, i );
+
+      p->iFree = 0;
+      p->nFree = 0;
+      for ( i = p->nObjs - 1; i > 0; i-- )
+        if ( !p->pMark[i] )
+        {
+          p->pVars[i] = -1;
+          p->pNexts[i] = p->iFree;
+          p->iFree = i;
+          p->nFree++;
+        }
+      Abc_BddManRehash( p );
+      memset( p->pMark, 0, p->nObjs );
+
+      memset( p->pCache, 0, sizeof(int) * ABC_BDD_CACHE_ENTRY * (p->nCacheMask + 1) );
+      p->nCreated = 0;
+    }
+
     /**Function*************************************************************
 
      Synopsis    [Printing BDD.]
@@ -1,67 +1,223 @@
 #pragma once
+#include <cassert>
+#include <compare>
+#include <initializer_list>
 #include <map>
+#include <utility>
+#include <vector>
 #include "abcbdd.hxx"
 
 namespace utils {
   namespace d = detail;
+  class abcbdd_remap;
+
   class abcbdd {
     public:
-      using remap_t = std::map<int, abcbdd>;
+      using remap_t = abcbdd_remap;
 
     private:
-      abcbdd (const int bdd) : bdd {bdd} {}
+      abcbdd (d::Abc_BddMan* p, const int bdd) : mgr {p}, bdd {bdd} { d::Abc_BddRef (mgr, bdd); }
 
     public:
-      static void init (int vars, int objs) { d::global_bddman = d::Abc_BddManAlloc (vars, objs); }
+      // Allocates a manager and makes it the current one of the calling
+      // thread.  New labels are built in the current manager; the operations
+      // on labels use the manager they were built in.
+      static d::Abc_BddMan* init (int vars, int objs) { return d::global_bddman = d::Abc_BddManAlloc (vars, objs); }
+      static d::Abc_BddMan* manager () { return d::global_bddman; }
+      static void set_manager (d::Abc_BddMan* p) { d::global_bddman = p; }
+      static int varnum () { return d::global_bddman->nVars; }
+      // Frees the nodes that no abcbdd refers to.  This also happens between
+      // operations when the table fills up.
+      static void gc () { d::Abc_BddManGc (d::global_bddman); }
 
       abcbdd () {}
-      abcbdd (const abcbdd& other) : bdd {other.bdd} { }
-      static abcbdd bddVar (int index) { return d::Abc_BddIthVar (index); }
-      static abcbdd bddOne () { return 1; }
-      static abcbdd bddZero () { return 0; }
+      abcbdd (const abcbdd& other) : mgr {other.mgr}, bdd {other.bdd} { d::Abc_BddRef (mgr, bdd); }
+      abcbdd (abcbdd&& other) : mgr {other.mgr}, bdd {other.bdd} { other.bdd = 0; }
+      ~abcbdd () { d::Abc_BddDeref (mgr, bdd); }
+
+      abcbdd& operator= (const abcbdd& other) {
+        d::Abc_BddRef (other.mgr, other.bdd);
+        d::Abc_BddDeref (mgr, bdd);
+        mgr = other.mgr;
+        bdd = other.bdd;
+        return *this;
+      }
+      abcbdd& operator= (abcbdd&& other) {
+        std::swap (mgr, other.mgr);
+        std::swap (bdd, other.bdd);
+        return *this;
+      }
 
-      abcbdd operator!() const { return d::Abc_LitNot (bdd); }
-      abcbdd operator~() const { return d::Abc_LitNot (bdd); }
+      static abcbdd bddVar (int index) { return {d::global_bddman, d::Abc_BddIthVar (index)}; }
+      static abcbdd bddOne () { return {d::global_bddman, 1}; }
+      static abcbdd bddZero () { return {d::global_bddman, 0}; }
 
-      bool operator== (const abcbdd&) const = default;
+      // The same function in manager p, which has at least as many variables.
+      abcbdd CopyTo (d::Abc_BddMan* p) const {
+        d::Abc_BddManCheckGc (p);
+        return {p, d::Abc_BddTransfer (mgr, p, bdd)};
+      }
+
+      abcbdd operator!() const { return {mgr, d::Abc_LitNot (bdd)}; }
+      abcbdd operator~() const { return !(*this); }
+
+      // The constants are shared by all managers.
+      bool operator== (const abcbdd& other) const {
+        return bdd == other.bdd and (isTerminal () or mgr == other.mgr);
+      }
+      std::strong_ordering operator<=> (const abcbdd& other) const {
+        if (bdd != other.bdd or isTerminal ())
+          return bdd <=> other.bdd;
+        return std::compare_three_way () (mgr, other.mgr);
+      }
 
-      abcbdd operator* (const abcbdd& other) const { return d::Abc_BddAnd (d::global_bddman, bdd, other.bdd); }
+      abcbdd operator* (const abcbdd& other) const { return And (other); }
       abcbdd& operator*= (const abcbdd& other) { return *this = *this * other; }
       abcbdd operator& (const abcbdd& other) const { return *this * other; }
       abcbdd& operator&= (const abcbdd& other) { return *this = *this * other; }
 
-      abcbdd operator+ (const abcbdd& other) const { return d::Abc_BddOr (d::global_bddman, bdd, other.bdd); }
+      abcbdd operator+ (const abcbdd& other) const { return Or (other); }
       abcbdd& operator+= (const abcbdd& other) { return *this = *this + other; }
       abcbdd operator| (const abcbdd& other) const { return *this + other; }
       abcbdd& operator|= (const abcbdd& other) { return *this = *this + other; }
 
-      abcbdd operator^ (const abcbdd& other) const { return (*this) * !other + !(*this) * other; }
+      abcbdd operator^ (const abcbdd& other) const {
+        auto p = man ({&other});
+        return {p, d::Abc_BddXor (p, bdd, other.bdd)};
+      }
       abcbdd& operator^= (const abcbdd& other) { return *this = *this ^ other; }
 
       int isTerminal () const { return bdd == 0 or bdd == 1; }
       int isOne () const { return bdd == 1; }
       int isZero () const { return bdd == 0; }
 
-      int TopVar () const { return d::Abc_BddVar (d::global_bddman, bdd); }
-      abcbdd Then () const { return d::Abc_BddThen (d::global_bddman, bdd); }
-      abcbdd Else () const { return d::Abc_BddElse (d::global_bddman, bdd); }
-      abcbdd And (const abcbdd& other) const { return d::Abc_BddAnd (d::global_bddman, bdd, other.bdd); }
-      abcbdd Or (const abcbdd& other) const { return d::Abc_BddOr (d::global_bddman, bdd, other.bdd); }
+      int TopVar () const { return d::Abc_BddVar (mgr, bdd); }
+      abcbdd Then () const { return {mgr, d::Abc_BddThen (mgr, bdd)}; }
+      abcbdd Else () const { return {mgr, d::Abc_BddElse (mgr, bdd)}; }
 
-      abcbdd Remap (const remap_t& map) const {
-        if (isZero () or isOne ()) return *this;
-        auto var = TopVar ();
-        auto el = map.find (var);
-        auto mapped_to = bddVar (var);
-        if (el != map.end ()) // preserve
-          mapped_to = el->second;
-        return mapped_to * Then ().Remap (map) |
-          !mapped_to * Else ().Remap (map);
+      // The value of the function when variable v is val (v), read off the
+      // nodes without making any BDD.
+      template <typename Valuation>
+      bool eval (const Valuation& val) const {
+        auto b = bdd;
+        while (b > 1)
+          b = val (d::Abc_BddVar (mgr, b)) ? d::Abc_BddThen (mgr, b) : d::Abc_BddElse (mgr, b);
+        return b == 1;
+      }
+      abcbdd And (const abcbdd& other) const {
+        auto p = man ({&other});
+        return {p, d::Abc_BddAnd (p, bdd, other.bdd)};
+      }
+      abcbdd Or (const abcbdd& other) const {
+        auto p = man ({&other});
+        return {p, d::Abc_BddOr (p, bdd, other.bdd)};
       }
+      abcbdd Ite (const abcbdd& g, const abcbdd& h) const {
+        auto p = man ({&g, &h});
+        return {p, d::Abc_BddIte (p, bdd, g.bdd, h.bdd)};
+      }
+      abcbdd AndNot (const abcbdd& other) const {
+        auto p = man ({&other});
+        return {p, d::Abc_BddAnd (p, bdd, d::Abc_LitNot (other.bdd))};
+      }
+      abcbdd Xnor (const abcbdd& other) const { return !(*this ^ other); }
+
+      // Variable sets are given as cubes.
+      abcbdd ExistAbstract (const abcbdd& vars) const {
+        auto p = man ({&vars});
+        return {p, d::Abc_BddExist (p, bdd, vars.bdd)};
+      }
+      abcbdd UnivAbstract (const abcbdd& vars) const {
+        auto p = man ({&vars});
+        return {p, d::Abc_BddForall (p, bdd, vars.bdd)};
+      }
+      // Exists vars. (*this & other), without building the conjunction.
+      abcbdd AndAbstract (const abcbdd& other, const abcbdd& vars) const {
+        auto p = man ({&other, &vars});
+        return {p, d::Abc_BddAndExist (p, bdd, other.bdd, vars.bdd)};
+      }
+
+      abcbdd Compose (const remap_t& map) const;
+      abcbdd Remap (const remap_t& map) const { return Compose (map); }
 
       auto GetBDD () const { return bdd; }
 
     private:
+      // The manager of the operands that are not constants.  Only the
+      // operands are referenced, so collections happen between top-level
+      // operations.
+      d::Abc_BddMan* man (std::initializer_list<const abcbdd*> others = {}) const {
+        auto p = isTerminal () ? nullptr : mgr;
+        for (auto other : others)
+          if (not other->isTerminal ()) {
+            assert (not p or p == other->mgr);
+            p = other->mgr;
+          }
+        if (not p)
+          p = mgr;
+        if (p)
+          d::Abc_BddManCheckGc (p);
+        return p;
+      }
+
+      d::Abc_BddMan* mgr = d::global_bddman;
       int bdd = 0;
+
+      friend class abcbdd_remap;
   };
+
+  // Maps variables to functions, for Compose.  The array of literals, and its
+  // identifier in the computed table, are built on first use and kept until
+  // the map is changed; the map can only be changed by assigning to map[var],
+  // which drops them.  A map is only used in one manager between changes.
+  class abcbdd_remap : private std::map<int, abcbdd> {
+      using map_t = std::map<int, abcbdd>;
+    public:
+      class entry {
+        public:
+          entry& operator= (const abcbdd& f) {
+            map.map_t::operator[] (var) = f;
+            map.mgr = nullptr;
+            map.id = 0;
+            map._lits.clear ();
+            return *this;
+          }
+        private:
+          friend class abcbdd_remap;
+          entry (abcbdd_remap& map, int var) : map {map}, var {var} {}
+          abcbdd_remap& map;
+          int var;
+      };
+
+      using map_t::begin, map_t::end, map_t::find, map_t::contains,
+        map_t::empty, map_t::size;
+
+      entry operator[] (int var) { return {*this, var}; }
+
+      const std::vector<int>& lits (d::Abc_BddMan* p) const {
+        if (not id) {
+          mgr = p;
+          id = d::Abc_BddManNewMapId (p);
+          auto size = empty () ? 0 : map_t::rbegin ()->first + 1;
+          for (int var = 0; var < size; ++var) {
+            auto el = find (var);
+            assert (el == end () or el->second.isTerminal () or el->second.mgr == p);
+            _lits.push_back (el == end () ? d::Abc_BddIthVar (var) : el->second.GetBDD ());
+          }
+        }
+        assert (mgr == p);
+        return _lits;
+      }
+      int map_id () const { return id; }
+    private:
+      mutable d::Abc_BddMan* mgr = nullptr;
+      mutable int id = 0;
+      mutable std::vector<int> _lits;
+  };
+
+  inline abcbdd abcbdd::Compose (const remap_t& map) const {
+    auto p = man ();
+    auto& lits = map.lits (p);
+    return {p, d::Abc_BddCompose (p, bdd, lits.data (), lits.size (), map.map_id ())};
+  }
 }
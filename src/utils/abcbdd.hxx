@@ -21,10 +21,15 @@ namespace utils {
         int                nObjsAlloc;    // the number of nodes allocated
         int *              pUnique;       // unique table for nodes
         int *              pNexts;        // next pointer for nodes
-        int *              pCache;        // array of triples <arg0, arg1, AND(arg0, arg1)>
+        int *              pCache;        // array of entries <op, arg1, arg2, arg3, res>
         int *              pObjs;         // array of pairs <cof0, cof1> for each node
-        unsigned char *    pVars;         // array of variables for each node
+        int *              pVars;         // array of variables for each node
         unsigned char *    pMark;         // array of marks for each BDD node
+        int *              pRefs;         // array of external references for each node
+        int                iFree;         // the first node of the free list (0 if empty)
+        int                nFree;         // the number of nodes in the free list
+        int                nCreated;      // the number of nodes created since the last collection
+        int                nMapIds;       // the number of variable maps given to Abc_BddCompose
         unsigned           nUniqueMask;   // selection mask for unique table
         unsigned           nCacheMask;    // selection mask for computed table
         int                nCacheLookups; // the number of computed table lookups
@@ -32,7 +37,8 @@ namespace utils {
         int                nMemory;       // total amount of memory used (in bytes)
     };
 
-    extern Abc_BddMan* global_bddman;
+    // The current manager of the calling thread.
+    extern thread_local Abc_BddMan* global_bddman;
 
     static inline int      Abc_Lit2Var( int Lit )                 { assert(Lit >= 0); return Lit >> 1;                          }
     static inline int      Abc_LitRegular( int Lit )              { assert(Lit >= 0); return Lit & ~01;                         }
@@ -42,6 +48,15 @@ namespace utils {
 #define ABC_CALLOC(type, num)    ((type *) calloc((num), sizeof(type)))
 #define ABC_FREE(obj)            ((obj) ? (free((char *) (obj)), (obj) = 0) : 0)
 #define ABC_FALLOC(type, num)    ((type *) memset(malloc(sizeof(type) * (num)), 0xff, sizeof(type) * (num)))
+#define ABC_REALLOC(type, obj, num) ((type *) realloc((char *) (obj), sizeof(type) * (num)))
+
+    // The variable of the constant node, above all the others.
+    static const int ABC_BDD_CONST_VAR = 0x7fffffff;
+
+    // The operations sharing the computed table; 0 marks an empty entry.
+    enum { ABC_BDD_OP_AND = 1, ABC_BDD_OP_XOR, ABC_BDD_OP_ITE, ABC_BDD_OP_EXIST, ABC_BDD_OP_FORALL, ABC_BDD_OP_COMPOSE,
+           ABC_BDD_OP_AND_EXIST };
+    static const int ABC_BDD_CACHE_ENTRY = 5;
 
     static inline int      Abc_MinInt( int a, int b )             { return a < b ?  a : b; }
 
@@ -53,11 +68,13 @@ namespace utils {
     static inline int      Abc_BddIthVar( int i )                        { return Abc_Var2Lit(i + 1, 0);                            }
     static inline unsigned Abc_BddHash( int Arg0, int Arg1, int Arg2 )   { return 12582917 * Arg0 + 4256249 * Arg1 + 741457 * Arg2; }
 
-    static inline int      Abc_BddVar( Abc_BddMan * p, int i )           { return (int)p->pVars[Abc_Lit2Var(i)];                    }
+    static inline int      Abc_BddVar( Abc_BddMan * p, int i )           { return p->pVars[Abc_Lit2Var(i)];                         }
     static inline int      Abc_BddThen( Abc_BddMan * p, int i )          { return Abc_LitNotCond(p->pObjs[Abc_LitRegular(i)], Abc_LitIsCompl(i));    }
     static inline int      Abc_BddElse( Abc_BddMan * p, int i )          { return Abc_LitNotCond(p->pObjs[Abc_LitRegular(i)+1], Abc_LitIsCompl(i));  }
 
     static inline int      Abc_BddMark( Abc_BddMan * p, int i )          { return (int)p->pMark[Abc_Lit2Var(i)];                    }
+    static inline void     Abc_BddRef( Abc_BddMan * p, int i )           { if ( i > 1 ) p->pRefs[Abc_Lit2Var(i)]++;                 }
+    static inline void     Abc_BddDeref( Abc_BddMan * p, int i )         { if ( i > 1 ) p->pRefs[Abc_Lit2Var(i)]--;                 }
     static inline void     Abc_BddSetMark( Abc_BddMan * p, int i, int m ){ p->pMark[Abc_Lit2Var(i)] = m;                            }
 
     ////////////////////////////////////////////////////////////////////////
@@ -75,16 +92,32 @@ namespace utils {
      SeeAlso     []
 
      ***********************************************************************/
+    void Abc_BddManGrow( Abc_BddMan * p );
+
     static inline int Abc_BddUniqueCreateInt( Abc_BddMan * p, int Var, int Then, int Else )
     {
       int *q = p->pUnique + (Abc_BddHash(Var, Then, Else) & p->nUniqueMask);
       for ( ; *q; q = p->pNexts + *q )
-        if ( (int)p->pVars[*q] == Var && p->pObjs[*q+*q] == Then && p->pObjs[*q+*q+1] == Else )
+        if ( p->pVars[*q] == Var && p->pObjs[*q+*q] == Then && p->pObjs[*q+*q+1] == Else )
           return Abc_Var2Lit(*q, 0);
-      if ( p->nObjs == p->nObjsAlloc )
-        printf( "Aborting because the number of nodes exceeded %d.\n", p->nObjsAlloc ), fflush(stdout);
-      assert( p->nObjs < p->nObjsAlloc );
-      *q = p->nObjs++;
+      if ( p->iFree )
+      {
+        *q = p->iFree;
+        p->iFree = p->pNexts[*q];
+        p->pNexts[*q] = 0;
+        p->nFree--;
+      }
+      else
+      {
+        if ( p->nObjs == p->nObjsAlloc )
+        {
+          // Nodes keep their index, so the literals held by callers stay valid.
+          Abc_BddManGrow( p );
+          return Abc_BddUniqueCreateInt( p, Var, Then, Else );
+        }
+        *q = p->nObjs++;
+      }
+      p->nCreated++;
       p->pVars[*q] = Var;
       p->pObjs[*q+*q] = Then;
       p->pObjs[*q+*q+1] = Else;
@@ -115,25 +148,59 @@ namespace utils {
      SeeAlso     []
 
      ***********************************************************************/
-    static inline int Abc_BddCacheLookup( Abc_BddMan * p, int Arg1, int Arg2 )
+    static inline int * Abc_BddCacheEntry( Abc_BddMan * p, int Op, int Arg1, int Arg2, int Arg3 )
+    {
+      return p->pCache + ABC_BDD_CACHE_ENTRY*((Abc_BddHash(Arg1, Arg2, Arg3) + 1000003 * Op) & p->nCacheMask);
+    }
+    static inline int Abc_BddCacheLookup( Abc_BddMan * p, int Op, int Arg1, int Arg2, int Arg3 )
     {
-      int * pEnt = p->pCache + 3*(Abc_BddHash(0, Arg1, Arg2) & p->nCacheMask);
+      int * pEnt = Abc_BddCacheEntry( p, Op, Arg1, Arg2, Arg3 );
       p->nCacheLookups++;
-      return (pEnt[0] == Arg1 && pEnt[1] == Arg2) ? pEnt[2] : -1;
+      return (pEnt[0] == Op && pEnt[1] == Arg1 && pEnt[2] == Arg2 && pEnt[3] == Arg3) ? pEnt[4] : -1;
     }
-    static inline int Abc_BddCacheInsert( Abc_BddMan * p, int Arg1, int Arg2, int Res )
+    static inline int Abc_BddCacheInsert( Abc_BddMan * p, int Op, int Arg1, int Arg2, int Arg3, int Res )
     {
-      int * pEnt = p->pCache + 3*(Abc_BddHash(0, Arg1, Arg2) & p->nCacheMask);
-      pEnt[0] = Arg1;  pEnt[1] = Arg2;  pEnt[2] = Res;
+      int * pEnt = Abc_BddCacheEntry( p, Op, Arg1, Arg2, Arg3 );
+      pEnt[0] = Op;  pEnt[1] = Arg1;  pEnt[2] = Arg2;  pEnt[3] = Arg3;  pEnt[4] = Res;
       p->nCacheMisses++;
       assert( Res >= 0 );
       return Res;
     }
 
+    /**Function*************************************************************
+
+     Synopsis    [Collects the nodes unreachable from referenced nodes.]
+
+     Description [This must only be called between operations, as the
+                  intermediate results of an operation are not referenced.
+                  The collection happens if three quarters of the table are
+                  used and enough nodes were created since the last one;
+                  the table is grown when full otherwise.]
+
+     SideEffects []
+
+     SeeAlso     []
+
+     ***********************************************************************/
+    void Abc_BddManGc( Abc_BddMan * p );
+    static inline void Abc_BddManCheckGc( Abc_BddMan * p )
+    {
+      if ( 4 * (p->nObjs - p->nFree) >= 3 * p->nObjsAlloc && 4 * p->nCreated >= p->nObjsAlloc )
+        Abc_BddManGc( p );
+    }
+
     Abc_BddMan * Abc_BddManAlloc( int nVars, int nObjs );
     void Abc_BddManFree( Abc_BddMan * p );
     int Abc_BddAnd( Abc_BddMan * p, int a, int b );
     int Abc_BddOr( Abc_BddMan * p, int a, int b );
+    int Abc_BddXor( Abc_BddMan * p, int a, int b );
+    int Abc_BddIte( Abc_BddMan * p, int f, int g, int h );
+    int Abc_BddExist( Abc_BddMan * p, int a, int Cube );
+    int Abc_BddForall( Abc_BddMan * p, int a, int Cube );
+    int Abc_BddAndExist( Abc_BddMan * p, int a, int b, int Cube );
+    static inline int Abc_BddManNewMapId( Abc_BddMan * p ) { return ++p->nMapIds; }
+    int Abc_BddCompose( Abc_BddMan * p, int a, const int * pMap, int nMap, int MapId );
+    int Abc_BddTransfer( Abc_BddMan * pFrom, Abc_BddMan * pTo, int a );
     void Abc_BddPrint( Abc_BddMan * p, int a );
   }
 }
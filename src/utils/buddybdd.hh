@@ -1,17 +1,43 @@
 #pragma once
 #include <map>
+#include <memory>
+#include <utility>
 #define register /* register */
 #include <buddy/masterbdd.hh>
 
 extern masterbdd global_mbuddy;
 
 namespace utils {
+  class buddybdd;
+  class buddybdd_remap;
+
+  // A BuDDy pair: a renaming of variables, or a substitution of variables by
+  // functions.  BuDDy caches replace and compose by pair, so a pair should be
+  // built once and reused.
+  class buddybdd_pair {
+    public:
+      buddybdd_pair () : pair {global_mbuddy.bdd_newpair ()} {}
+      buddybdd_pair (const buddybdd_pair&) = delete;
+      buddybdd_pair& operator= (const buddybdd_pair&) = delete;
+      ~buddybdd_pair () { global_mbuddy.bdd_freepair (pair); }
+
+      void rename (int oldvar, int newvar) { global_mbuddy.bdd_setpair (pair, oldvar, newvar); }
+      void substitute (int var, const buddybdd& f);
+
+      bddPair* get () const { return pair; }
+    private:
+      bddPair* pair;
+  };
+
   class buddybdd {
     public:
-      using remap_t = std::map<int, buddybdd>;
+      using remap_t = buddybdd_remap;
 
     private:
-      buddybdd (const int bdd) : bdd {bdd} {}
+      // Handles are reference counted, so that BuDDy's garbage collector can
+      // reclaim what is not held anymore; results of BuDDy operations come
+      // with no reference and are taken here.
+      buddybdd (const int bdd) : bdd {global_mbuddy.bdd_addref (bdd)} {}
 
     public:
       static void init (int vars, int objs) {
@@ -19,8 +45,36 @@ namespace utils {
         global_mbuddy.bdd_setvarnum (vars);
       }
 
+      // Variable reordering.  BuDDy reorders nodes in place, so handles keep
+      // denoting the same functions; TopVar, Then and Else follow the current
+      // order, which may not be the index order anymore.  The variables of a
+      // block are moved together, in their relative order; if no block is
+      // given, each variable is its own block.
+      static void add_var_block (int first, int last) {
+        global_mbuddy.bdd_intaddvarblock (first, last, BDD_REORDER_FIXED);
+      }
+      // Reorders when the number of nodes doubles; BDD_REORDER_NONE disables.
+      static void autoreorder (int method = BDD_REORDER_SIFT) {
+        make_var_blocks ();
+        global_mbuddy.bdd_autoreorder (method);
+      }
+      static void reorder (int method = BDD_REORDER_SIFT) {
+        make_var_blocks ();
+        global_mbuddy.bdd_reorder (method);
+      }
+
       buddybdd () {}
-      buddybdd (const buddybdd& other) : bdd {other.bdd} { }
+      buddybdd (const buddybdd& other) : bdd {global_mbuddy.bdd_addref (other.bdd)} { }
+      buddybdd (buddybdd&& other) : bdd {other.bdd} { other.bdd = 0; }
+      ~buddybdd () { global_mbuddy.bdd_delref (bdd); }
+
+      buddybdd& operator= (const buddybdd& other) {
+        global_mbuddy.bdd_addref (other.bdd);
+        global_mbuddy.bdd_delref (bdd);
+        bdd = other.bdd;
+        return *this;
+      }
+      buddybdd& operator= (buddybdd&& other) { std::swap (bdd, other.bdd); return *this; }
       static buddybdd bddVar (int index) { return global_mbuddy.bdd_ithvar (index); }
       static buddybdd bddOne () { return 1; }
       static buddybdd bddZero () { return 0; }
@@ -40,9 +94,15 @@ namespace utils {
       buddybdd operator| (const buddybdd& other) const { return *this + other; }
       buddybdd& operator|= (const buddybdd& other) { return *this = *this + other; }
 
-      buddybdd operator^ (const buddybdd& other) const { return (*this) * !other + !(*this) * other; }
+      buddybdd operator^ (const buddybdd& other) const { return global_mbuddy.bdd_apply (bdd, other.bdd, bddop_xor); }
       buddybdd& operator^= (const buddybdd& other) { return *this = *this ^ other; }
 
+      // Without complement edges, negation is an operation of its own, so
+      // these are single applications.
+      buddybdd AndNot (const buddybdd& other) const { return global_mbuddy.bdd_apply (bdd, other.bdd, bddop_diff); }
+      buddybdd Xnor (const buddybdd& other) const { return global_mbuddy.bdd_apply (bdd, other.bdd, bddop_biimp); }
+      buddybdd Ite (const buddybdd& g, const buddybdd& h) const { return global_mbuddy.bdd_ite (bdd, g.bdd, h.bdd); }
+
       int isTerminal () const { return bdd == 0 or bdd == 1; }
       int isOne () const { return bdd == 1; }
       int isZero () const { return bdd == 0; }
@@ -51,20 +111,84 @@ namespace utils {
       buddybdd Then () const { return global_mbuddy.bdd_high (bdd); }
       buddybdd Else () const { return global_mbuddy.bdd_low (bdd); }
 
-      buddybdd Remap (const remap_t& map) const {
-        if (isZero () or isOne ()) return *this;
-        auto var = TopVar ();
-        auto el = map.find (var);
-        auto mapped_to = bddVar (var);
-        if (el != map.end ()) // preserve
-          mapped_to = el->second;
-        return mapped_to * Then ().Remap (map) |
-          !mapped_to * Else ().Remap (map);
+      // The value of the function when variable v is val (v), read off the
+      // nodes without making any BDD.
+      template <typename Valuation>
+      bool eval (const Valuation& val) const {
+        auto b = bdd;
+        while (b > 1)
+          b = val (global_mbuddy.bdd_var (b)) ? global_mbuddy.bdd_high (b) : global_mbuddy.bdd_low (b);
+        return b == 1;
       }
 
+      // Variable sets are given as cubes, as in BuDDy.
+      buddybdd ExistAbstract (const buddybdd& vars) const { return global_mbuddy.bdd_exist (bdd, vars.bdd); }
+      buddybdd UnivAbstract (const buddybdd& vars) const { return global_mbuddy.bdd_forall (bdd, vars.bdd); }
+      // Existential quantification of the variables *not* in vars.
+      buddybdd Project (const buddybdd& vars) const { return global_mbuddy.bdd_existcomp (bdd, vars.bdd); }
+      // Exists vars. (*this & other), without building the conjunction.
+      buddybdd AndAbstract (const buddybdd& other, const buddybdd& vars) const {
+        return global_mbuddy.bdd_appex (bdd, other.bdd, bddop_and, vars.bdd);
+      }
+      buddybdd Support () const { return global_mbuddy.bdd_support (bdd); }
+
+      buddybdd Replace (const buddybdd_pair& pair) const { return global_mbuddy.bdd_replace (bdd, pair.get ()); }
+      buddybdd Compose (const buddybdd_pair& pair) const { return global_mbuddy.bdd_veccompose (bdd, pair.get ()); }
+      buddybdd Remap (const remap_t& map) const;
+
       auto GetBDD () const { return bdd; }
 
     private:
+      static void make_var_blocks () {
+        if (not global_mbuddy.bdd_hasvarblocks ())
+          global_mbuddy.bdd_varblockall ();
+      }
+
       int bdd = 0;
   };
+
+  // Maps variables to functions, for Remap.  The BuDDy pair is built on first
+  // use and kept until the map is changed; the map can only be changed by
+  // assigning to map[var], which drops the pair.
+  class buddybdd_remap : private std::map<int, buddybdd> {
+      using map_t = std::map<int, buddybdd>;
+    public:
+      class entry {
+        public:
+          entry& operator= (const buddybdd& f) {
+            map.map_t::operator[] (var) = f;
+            map._pair.reset ();
+            return *this;
+          }
+        private:
+          friend class buddybdd_remap;
+          entry (buddybdd_remap& map, int var) : map {map}, var {var} {}
+          buddybdd_remap& map;
+          int var;
+      };
+
+      using map_t::begin, map_t::end, map_t::find, map_t::contains,
+        map_t::empty, map_t::size;
+
+      entry operator[] (int var) { return {*this, var}; }
+
+      const buddybdd_pair& pair () const {
+        if (not _pair) {
+          _pair = std::make_shared<buddybdd_pair> ();
+          for (auto&& [var, f] : *this)
+            _pair->substitute (var, f);
+        }
+        return *_pair;
+      }
+    private:
+      mutable std::shared_ptr<buddybdd_pair> _pair;
+  };
+
+  inline void buddybdd_pair::substitute (int var, const buddybdd& f) {
+    global_mbuddy.bdd_setbddpair (pair, var, f.GetBDD ());
+  }
+
+  inline buddybdd buddybdd::Remap (const remap_t& map) const {
+    return Compose (map.pair ());
+  }
 }
@@ -1,17 +1,19 @@
 #pragma once
 #include <map>
 #include <memory>
+#include <tuple>
 
 namespace utils {
   template <typename Ret, typename... Args>
   class cache_t {
       using cache_key_t = std::tuple<Args...>;
-      using cache_map_t = std::map <cache_key_t, Ret>;
+      // Transparent, so that lookups do not copy the arguments.
+      using cache_map_t = std::map <cache_key_t, Ret, std::less<>>;
     public:
       cache_t () {}
 
       auto get (const Args&... args) const {
-        auto cached = cache.find (std::make_tuple (args...));
+        auto cached = cache.find (std::forward_as_tuple (args...));
         return cached != cache.end () ? &cached->second : nullptr;
       }
 
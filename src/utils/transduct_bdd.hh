@@ -3,10 +3,13 @@
 #include <sylvan.h>
 #include <sylvan_obj.hpp>
 
+#include <memory>
+
 #include <utils/cache.hh>
 
 #include <labels/sylvanbdd.hh>
 #include <labels/abcbdd.hh>
+#include <labels/buddybdd.hh>
 
 namespace utils {
 
@@ -47,29 +50,118 @@ namespace utils {
                             p_map);
   }
 
+  /* With Sylvan labels, if each output variable directly follows its (even)
+   * target variable, as in the interleaved encoding of upsets, a label that
+   * only uses the target and output variables is mapped by a single relnext.
+   * Other labels and other variable maps are projected then composed. */
   template <class T1, class T2>
   static auto transduct(T1&& state, T2&& trans,
                         std::vector<labels::sylvanbdd> output_vars,
                         std::vector<labels::sylvanbdd> to_vars) {
     using sylvan::sylvan_project_RUN;
+    using sylvan::sylvan_relnext_RUN;
     using Bdd = sylvan::Bdd;
-    using BddMap = sylvan::BddMap;
+
+    struct label_map_t {
+        bool interleaved = true;
+        // The target and output variables, for relnext.
+        Bdd relvars = Bdd::bddOne ();
+        Bdd outputs = Bdd::bddOne ();
+        sylvan::BddMap m;
+    };
+
+    assert (output_vars.size () == to_vars.size () and output_vars.size () != 0);
+    static auto cache = make_cache<label_map_t> (output_vars, to_vars);
+    auto p_map = cache.get (output_vars, to_vars);
+    if (not p_map) {
+      label_map_t map;
+      for (size_t i = 0; i < output_vars.size (); ++i) {
+        map.interleaved &= (to_vars[i].TopVar () % 2 == 0 and
+                            output_vars[i].TopVar () == to_vars[i].TopVar () + 1);
+        map.relvars *= to_vars[i] * output_vars[i];
+        map.outputs *= output_vars[i];
+        map.m.put (output_vars[i].TopVar (), to_vars[i]);
+      }
+      p_map = &cache (map, output_vars, to_vars);
+    }
+
+    // The cache entries are never removed, so their address identifies the map.
+    return state.transduct (trans,
+                            [p_map] (const labels::sylvanbdd& b) -> labels::sylvanbdd {
+                              if (p_map->interleaved and b.Support ().ExistAbstract (p_map->relvars).isOne ())
+                                return Bdd (sylvan_relnext (sylvan::sylvan_true, b.GetBDD (),
+                                                            p_map->relvars.GetBDD ()));
+                              return Bdd (sylvan_project (b.GetBDD (), p_map->outputs.GetBDD ())).Compose (p_map->m);
+                            },
+                            p_map);
+  }
+
+  /* With BuDDy labels, the projection and renaming are BuDDy's existcomp and
+   * replace, both cached, with one pair per variable map. */
+  template <class T1, class T2>
+  static auto transduct(T1&& state, T2&& trans,
+                        std::vector<labels::buddybdd> output_vars,
+                        std::vector<labels::buddybdd> to_vars) {
+    using Bdd = utils::buddybdd;
+
+    struct label_map_t {
+        Bdd vars = Bdd::bddOne ();
+        std::shared_ptr<buddybdd_pair> pair = std::make_shared<buddybdd_pair> ();
+    };
 
     assert (output_vars.size () == to_vars.size () and output_vars.size () != 0);
-    // Construct the map output_var -> to_var.
-    BddMap m;
-    Bdd bddoutputvars = Bdd::bddOne ();
-    for (size_t i = 0; i < output_vars.size (); ++i) {
-      m.put (output_vars[i].TopVar (), to_vars[i]);
-      bddoutputvars *= output_vars[i];
+    static auto cache = make_cache<label_map_t> (output_vars, to_vars);
+    auto p_map = cache.get (output_vars, to_vars);
+    if (not p_map) {
+      label_map_t map;
+      for (size_t i = 0; i < output_vars.size (); ++i) {
+        map.vars *= output_vars[i];
+        map.pair->rename (output_vars[i].TopVar (), to_vars[i].TopVar ());
+      }
+      p_map = &cache (map, output_vars, to_vars);
     }
 
+    // The cache entries are never removed, so their address identifies the map.
     return state.transduct (trans,
-                            [&bddoutputvars, &m] (const labels::sylvanbdd& b) -> labels::sylvanbdd {
-                              return Bdd (sylvan_project (b.GetBDD (), bddoutputvars.GetBDD ())).Compose (m);
+                            [p_map] (const labels::buddybdd& b) -> labels::buddybdd {
+                              return b.Project (p_map->vars).Replace (*p_map->pair);
                             },
-                            *((size_t*) &m) // This is because BddMap doesn't expose the Bdd.
-      );
+                            p_map);
+  }
+
+  /* With ABC labels, the projection and renaming are the manager's cached
+   * quantification and composition. */
+  template <class T1, class T2>
+  static auto transduct(T1&& state, T2&& trans,
+                        std::vector<labels::abcbdd> output_vars,
+                        std::vector<labels::abcbdd> to_vars) {
+    using Bdd = utils::abcbdd;
+
+    struct label_map_t {
+        // The variables that are not output variables.
+        Bdd others = Bdd::bddOne ();
+        Bdd::remap_t m;
+    };
+
+    assert (output_vars.size () == to_vars.size () and output_vars.size () != 0);
+    static auto cache = make_cache<label_map_t> (output_vars, to_vars);
+    auto p_map = cache.get (output_vars, to_vars);
+    if (not p_map) {
+      label_map_t map;
+      for (size_t i = 0; i < output_vars.size (); ++i)
+        map.m[output_vars[i].TopVar ()] = to_vars[i];
+      for (int var = 0; var < Bdd::varnum (); ++var)
+        if (not map.m.contains (var))
+          map.others *= Bdd::bddVar (var);
+      p_map = &cache (map, output_vars, to_vars);
+    }
+
+    // The cache entries are never removed, so their address identifies the map.
+    return state.transduct (trans,
+                            [p_map] (const labels::abcbdd& b) -> labels::abcbdd {
+                              return b.ExistAbstract (p_map->others).Compose (p_map->m);
+                            },
+                            p_map);
   }
 
   template <typename Bdd>
@@ -0,0 +1,192 @@
+#pragma once
+#include <array>
+#include <map>
+#include <compare>
+#include <cstdint>
+#include <cassert>
+
+namespace utils {
+  // A Boolean function over N variables stored as its truth table: bit a is
+  // the value of the function when variable i is bit i of a.  All operations
+  // are loops over machine words, which the compiler vectorizes when the
+  // table spans several words.  Tables are stored by value, so N is capped at
+  // 16 (8 KiB per table).
+  template <size_t N>
+  class truthtable {
+      static_assert (N <= 16, "Truth tables have 2^N bits and are stored by value.");
+      using word_t = uint64_t;
+      static constexpr size_t word_log = 6;
+      static constexpr size_t nbits = size_t {1} << N;
+      static constexpr size_t nwords = N <= word_log ? 1 : nbits >> word_log;
+      // The bits of a word that are used (all of them if N >= 6).
+      static constexpr word_t used = N >= word_log ? ~word_t {0} : (word_t {1} << nbits) - 1;
+      // The truth table of variable i < 6 within a word.
+      static constexpr word_t var_word[word_log] = {
+        0xAAAAAAAAAAAAAAAA, 0xCCCCCCCCCCCCCCCC, 0xF0F0F0F0F0F0F0F0,
+        0xFF00FF00FF00FF00, 0xFFFF0000FFFF0000, 0xFFFFFFFF00000000
+      };
+
+    public:
+      using remap_t = std::map<int, truthtable>;
+
+      truthtable () : words {} {}
+
+      static truthtable bddVar (int index) {
+        assert (index >= 0 and (size_t) index < N);
+        truthtable r;
+        for (size_t i = 0; i < nwords; ++i)
+          if ((size_t) index < word_log)
+            r.words[i] = var_word[index] & used;
+          else
+            r.words[i] = ((i >> (index - word_log)) & 1) ? ~word_t {0} : 0;
+        return r;
+      }
+      static truthtable bddOne () { truthtable r; r.words.fill (used); return r; }
+      static truthtable bddZero () { return truthtable (); }
+
+      truthtable operator!() const {
+        truthtable r;
+        for (size_t i = 0; i < nwords; ++i)
+          r.words[i] = ~words[i] & used;
+        return r;
+      }
+      truthtable operator~() const { return !(*this); }
+
+      bool operator== (const truthtable&) const = default;
+      auto operator<=> (const truthtable&) const = default;
+
+      truthtable operator* (const truthtable& other) const {
+        truthtable r;
+        for (size_t i = 0; i < nwords; ++i)
+          r.words[i] = words[i] & other.words[i];
+        return r;
+      }
+      truthtable& operator*= (const truthtable& other) { return *this = *this * other; }
+      truthtable operator& (const truthtable& other) const { return *this * other; }
+      truthtable& operator&= (const truthtable& other) { return *this = *this * other; }
+
+      truthtable operator+ (const truthtable& other) const {
+        truthtable r;
+        for (size_t i = 0; i < nwords; ++i)
+          r.words[i] = words[i] | other.words[i];
+        return r;
+      }
+      truthtable& operator+= (const truthtable& other) { return *this = *this + other; }
+      truthtable operator| (const truthtable& other) const { return *this + other; }
+      truthtable& operator|= (const truthtable& other) { return *this = *this + other; }
+
+      truthtable operator^ (const truthtable& other) const {
+        truthtable r;
+        for (size_t i = 0; i < nwords; ++i)
+          r.words[i] = words[i] ^ other.words[i];
+        return r;
+      }
+      truthtable& operator^= (const truthtable& other) { return *this = *this ^ other; }
+
+      truthtable AndNot (const truthtable& other) const {
+        truthtable r;
+        for (size_t i = 0; i < nwords; ++i)
+          r.words[i] = words[i] & ~other.words[i];
+        return r;
+      }
+      truthtable Xnor (const truthtable& other) const {
+        truthtable r;
+        for (size_t i = 0; i < nwords; ++i)
+          r.words[i] = ~(words[i] ^ other.words[i]) & used;
+        return r;
+      }
+      truthtable Ite (const truthtable& g, const truthtable& h) const {
+        truthtable r;
+        for (size_t i = 0; i < nwords; ++i)
+          r.words[i] = (words[i] & g.words[i]) | (~words[i] & h.words[i]);
+        return r;
+      }
+
+      int isTerminal () const { return isZero () or isOne (); }
+      int isOne () const { return *this == bddOne (); }
+      int isZero () const { return *this == bddZero (); }
+
+      // As for BDDs, the first variable the function depends on, and the
+      // cofactors of that variable.
+      int TopVar () const {
+        assert (not isTerminal ());
+        for (size_t var = 0; var < N; ++var)
+          if (cofactor (var, true) != cofactor (var, false))
+            return var;
+        assert (false);
+        return -1;
+      }
+      truthtable Then () const { return cofactor (TopVar (), true); }
+      truthtable Else () const { return cofactor (TopVar (), false); }
+
+      truthtable Remap (const remap_t& map) const {
+        // Mapping a variable to its negation is a permutation of the table.
+        if (map.size () == 1 and map.begin ()->second == !bddVar (map.begin ()->first))
+          return flip (map.begin ()->first);
+
+        truthtable r;
+        for (size_t a = 0; a < nbits; ++a) {
+          auto mapped = a;
+          for (auto&& [var, f] : map)
+            mapped = (mapped & ~(size_t {1} << var)) | ((size_t) f.bit (a) << var);
+          if (bit (mapped))
+            r.words[a >> word_log] |= word_t {1} << (a & 63);
+        }
+        return r;
+      }
+
+      // The value of the function when variable v is val (v).
+      template <typename Valuation>
+      bool eval (const Valuation& val) const {
+        size_t a = 0;
+        for (size_t var = 0; var < N; ++var)
+          a |= (size_t) (bool) val (var) << var;
+        return bit (a);
+      }
+
+    private:
+      bool bit (size_t a) const { return (words[a >> word_log] >> (a & 63)) & 1; }
+
+      // The function with variable var fixed to val.
+      truthtable cofactor (size_t var, bool val) const {
+        truthtable r;
+        if (var < word_log) {
+          auto shift = size_t {1} << var;
+          for (size_t i = 0; i < nwords; ++i)
+            if (val) {
+              auto w = words[i] & var_word[var];
+              r.words[i] = w | (w >> shift);
+            }
+            else {
+              auto w = words[i] & ~var_word[var];
+              r.words[i] = (w | (w << shift)) & used;
+            }
+        }
+        else {
+          auto stride = size_t {1} << (var - word_log);
+          for (size_t i = 0; i < nwords; ++i)
+            r.words[i] = words[val ? (i | stride) : (i & ~stride)];
+        }
+        return r;
+      }
+
+      // The function with variable var negated.
+      truthtable flip (size_t var) const {
+        truthtable r;
+        if (var < word_log) {
+          auto shift = size_t {1} << var;
+          for (size_t i = 0; i < nwords; ++i)
+            r.words[i] = (((words[i] & var_word[var]) >> shift) |
+                          ((words[i] & ~var_word[var]) << shift)) & used;
+        }
+        else {
+          auto stride = size_t {1} << (var - word_log);
+          for (size_t i = 0; i < nwords; ++i)
+            r.words[i] = words[i ^ stride];
+        }
+        return r;
+      }
+
+      std::array<word_t, nwords> words;
+  };
+}
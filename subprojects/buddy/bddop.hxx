@@ -148,6 +148,7 @@ int masterbdd::bdd_operator_init(int cachesize)
    quantvarset = NULL;
    cacheratio = 0;
    supportSet = NULL;
+   supportSize = 0;
 
    return 0;
 }
@@ -167,6 +168,8 @@ void masterbdd::bdd_operator_done(void)
 
    if (supportSet != NULL)
      free(supportSet);
+   supportSet = NULL;
+   supportSize = 0;
 }
 
 
@@ -380,6 +383,7 @@ BDD masterbdd::bdd_not(BDD r)
 }
 
 
+/* Both directions are cached, so that negating back is a lookup. */
 BDD masterbdd::not_rec(BDD r)
 {
    BddCacheData *entry;
@@ -412,6 +416,11 @@ BDD masterbdd::not_rec(BDD r)
    entry->i.c = bddop_not;
    entry->i.res = res;
 
+   entry = BddCache_lookup(&applycache, NOTHASH(res));
+   entry->i.a = res;
+   entry->i.c = bddop_not;
+   entry->i.res = r;
+
    return res;
 }
 
@@ -1837,7 +1846,7 @@ RETURN  {* The quantified BDD. *}
 */
 BDD masterbdd::bdd_forall(BDD r, BDD var)
 {
-   return quantify(r, var, bddop_and, 0, CACHEID_EXIST);
+   return quantify(r, var, bddop_and, 0, CACHEID_FORALL);
 }
 
 /*
@@ -1852,7 +1861,7 @@ RETURN  {* The quantified BDD. *}
 */
 BDD masterbdd::bdd_forallcomp(BDD r, BDD var)
 {
-   return quantify(r, var, bddop_and, 1, CACHEID_EXISTC);
+   return quantify(r, var, bddop_and, 1, CACHEID_FORALLC);
 }
 
 
@@ -2300,7 +2309,6 @@ RETURN  {* A BDD variable set. *}
 BDD masterbdd::bdd_support(BDD r)
 {
    BddCacheData *entry;
-   static int  supportSize = 0;
    int n;
    int res=1;
 
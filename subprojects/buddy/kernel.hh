@@ -58,6 +58,12 @@ typedef struct s_BddNode /* Node table entry */
    int next;
 } BddNode;
 
+typedef struct s_BddUnique /* Unique table entry */
+{
+   unsigned int hash;
+   int node;
+} BddUnique;
+
 
 /*=== KERNEL DEFINITIONS ===============================================*/
 
@@ -77,7 +77,7 @@ static const char *errorstrings[BDD_ERRNUM] =
 
 /*=== OTHER INTERNAL DEFINITIONS =======================================*/
 
-#define NODEHASH(lvl,l,h) (TRIPLE(lvl,l,h) % bddnodesize)
+#define NODEHASH(lvl,l,h) (TRIPLE(lvl,l,h))
 
 
 /*************************************************************************
@@ -121,7 +121,9 @@ int masterbdd::bdd_init(int initnodesize, int cs)
    if ((bddnodes=(BddNode*)malloc(sizeof(BddNode)*bddnodesize)) == NULL)
       return bdd_error(BDD_MEMORY);
 
-   if ((bddhash=(int*)calloc(bddnodesize, sizeof(*bddhash))) == NULL)
+   bddhash = NULL;
+   bdduniq = NULL;
+   if (bdd_unique_reset() < 0)
      {
        free(bddnodes);
        return bdd_error(BDD_MEMORY);
@@ -202,12 +204,14 @@ void masterbdd::bdd_done(void)
    bdd_pairs_done();
 
    free(bddnodes);
+   free(bdduniq);
    free(bddrefstack);
    free(bddvarset);
    free(bddvar2level);
    free(bddlevel2var);
 
    bddnodes = NULL;
+   bdduniq = NULL;
    bddrefstack = NULL;
    bddvarset = NULL;
 
@@ -956,6 +960,8 @@ void masterbdd::bdd_gbc_rehash(void)
 {
    int n;
 
+   bdd_unique_reset();
+
    bddfreepos = 0;
    bddfreenum = 0;
 
@@ -964,13 +970,7 @@ void masterbdd::bdd_gbc_rehash(void)
       register BddNode *node = &bddnodes[n];
 
       if (LOWp(node) != -1)
-      {
-	 register unsigned int hash;
-
-	 hash = NODEHASH(LEVELp(node), LOWp(node), HIGHp(node));
-	 node->next = bddhash[hash];
-	 bddhash[hash] = n;
-      }
+	 bdd_unique_insert(NODEHASH(LEVELp(node), LOWp(node), HIGHp(node)), n);
       else
       {
 	 node->next = bddfreepos;
@@ -1007,7 +1007,7 @@ void masterbdd::bdd_gbc(void)
 	 bdd_mark(n);
    }
 
-   memset(bddhash, 0, bddnodesize*sizeof(*bddhash));
+   bdd_unique_reset();
 
    bddfreepos = 0;
    bddfreenum = 0;
@@ -1018,12 +1018,8 @@ void masterbdd::bdd_gbc(void)
 
       if ((LEVELp(node) & MARKON)  &&  LOWp(node) != -1)
       {
-	 register unsigned int hash;
-
 	 LEVELp(node) &= MARKOFF;
-	 hash = NODEHASH(LEVELp(node), LOWp(node), HIGHp(node));
-	 node->next = bddhash[hash];
-	 bddhash[hash] = n;
+	 bdd_unique_insert(NODEHASH(LEVELp(node), LOWp(node), HIGHp(node)), n);
       }
       else
       {
@@ -1248,10 +1244,53 @@ void masterbdd::bdd_unmark_upto(int i, int level)
   Unique node table functions
 *************************************************************************/
 
+/* The unique table is open addressed with linear probing.  Each entry
+   keeps the full hash of its node next to the node index, so that probing
+   mostly stays within one cache line and rarely reads a node that does not
+   match.  Nodes are never removed one by one: the table is rebuilt by the
+   garbage collector and on resize.  Reordering uses bddhash instead.  */
+
+/* Empties the unique table, growing it first so that it stays at most four
+   fifths full with every node in use. */
+int masterbdd::bdd_unique_reset(void)
+{
+   unsigned int size = 1;
+
+   while (size < (unsigned int)bddnodesize + bddnodesize/4)
+      size <<= 1;
+
+   if (bdduniq != NULL  &&  size == bdduniqmask+1)
+   {
+      memset(bdduniq, 0, size*sizeof(*bdduniq));
+      return 0;
+   }
+
+   free(bdduniq);
+   if ((bdduniq=(BddUnique*)calloc(size, sizeof(*bdduniq))) == NULL)
+      return bdd_error(BDD_MEMORY);
+   bdduniqmask = size-1;
+
+   return 0;
+}
+
+
+void masterbdd::bdd_unique_insert(unsigned int hash, int n)
+{
+   unsigned int pos = hash & bdduniqmask;
+
+   while (bdduniq[pos].node != 0)
+      pos = (pos+1) & bdduniqmask;
+
+   bdduniq[pos].hash = hash;
+   bdduniq[pos].node = n;
+}
+
+
 int masterbdd::bdd_makenode(unsigned int level, int low, int high)
 {
    register BddNode *node;
    register unsigned int hash;
+   register unsigned int pos;
    register int res;
 
 #ifdef CACHESTATS
@@ -1264,11 +1303,12 @@ int masterbdd::bdd_makenode(unsigned int level, int low, int high)
 
       /* Try to find an existing node of this kind */
    hash = NODEHASH(level, low, high);
-   res = bddhash[hash];
 
-   while(res != 0)
+   for (pos = hash & bdduniqmask ; (res=bdduniq[pos].node) != 0 ;
+	pos = (pos+1) & bdduniqmask)
    {
-      if (LEVEL(res) == level  &&  LOW(res) == low  &&  HIGH(res) == high)
+      if (bdduniq[pos].hash == hash  &&
+	  LEVEL(res) == level  &&  LOW(res) == low  &&  HIGH(res) == high)
       {
 #ifdef CACHESTATS
 	 bddcachestats.uniqueHit++;
@@ -1276,7 +1316,6 @@ int masterbdd::bdd_makenode(unsigned int level, int low, int high)
 	 return res;
       }
 
-      res = bddnodes[res].next;
 #ifdef CACHESTATS
       bddcachestats.uniqueChain++;
 #endif
@@ -1303,10 +1342,7 @@ int masterbdd::bdd_makenode(unsigned int level, int low, int high)
       }
 
       if ((bddfreenum*100) / bddnodesize <= minfreenodes)
-      {
 	 bdd_noderesize(1);
-	 hash = NODEHASH(level, low, high);
-      }
 
 	 /* Panic if that is not possible */
       if (bddfreepos == 0)
@@ -1315,6 +1351,11 @@ int masterbdd::bdd_makenode(unsigned int level, int low, int high)
 	 bdderrorcond = abs(BDD_NODENUM);
 	 return 0;
       }
+
+	 /* The table was rebuilt, find a free entry again */
+      for (pos = hash & bdduniqmask ; bdduniq[pos].node != 0 ;
+	   pos = (pos+1) & bdduniqmask)
+	 ;
    }
 
       /* Build new node */
@@ -1329,8 +1370,8 @@ int masterbdd::bdd_makenode(unsigned int level, int low, int high)
    HIGHp(node) = high;
 
       /* Insert node */
-   node->next = bddhash[hash];
-   bddhash[hash] = res;
+   bdduniq[pos].hash = hash;
+   bdduniq[pos].node = res;
 
    return res;
 }
@@ -1363,16 +1404,12 @@ int masterbdd::bdd_noderesize(int doRehash)
       return bdd_error(BDD_MEMORY);
    bddnodes = newnodes;
 
-   /* An error while reallocating bddhash is very unlikely, because
+   /* Without rehashing, we are reordering and the per-level chains in
+      bddhash must be kept.  With it, bdd_gbc_rehash grows the unique
+      table.  An error while reallocating bddhash is very unlikely, because
       the new bddhash should fit easily in the area freed by the old
       bddnode.  */
-   if (doRehash)
-     {
-       free(bddhash);
-       if ((bddhash=(int*)calloc(bddnodesize, sizeof(*bddhash))) == NULL)
-	 return bdd_error(BDD_MEMORY);
-     }
-   else
+   if (!doRehash)
      {
        bddhash = (int*)realloc(bddhash, sizeof(*bddhash)*bddnodesize);
        if (bddhash == NULL)
@@ -215,6 +215,7 @@ class masterbdd {
     int      bdd_addvarblock(BDD, int);
     int      bdd_intaddvarblock(int, int, int);
     void     bdd_varblockall(void);
+    int      bdd_hasvarblocks(void) const;
     bddfilehandler bdd_blockfile_hook(bddfilehandler);
     int      bdd_autoreorder(int);
     int      bdd_autoreorder_times(int, int);
@@ -295,7 +296,9 @@ class masterbdd {
     int          bddmaxnodesize;        /* Maximum allowed number of nodes */
     int          bddmaxnodeincrease;    /* Max. # of nodes used to inc. table */
     BddNode*     bddnodes;          /* All of the bdd nodes */
-    int*         bddhash;           /* Unicity hash table */
+    BddUnique*   bdduniq;           /* Unicity table, open addressing */
+    unsigned int bdduniqmask;       /* Size of bdduniq minus one */
+    int*         bddhash;           /* Per-level chains while reordering */
     int          bddfreepos;        /* First free node */
     int          bddfreenum;        /* Number of free nodes */
     long int     bddproduced;       /* Number of new nodes ever produced */
@@ -322,6 +325,8 @@ class masterbdd {
     bdd2inthandler resize_handler;  /* Node-table-resize handler */
 
     void bdd_gbc_rehash(void);
+    int  bdd_unique_reset(void);
+    void bdd_unique_insert(unsigned int, int);
 
 
     /****************************************************************** bddop */
@@ -343,6 +348,7 @@ class masterbdd {
     int supportMin;              /* Min. used level in support calc. */
     int supportMax;              /* Max. used level in support calc. */
     int* supportSet;             /* The found support set */
+    int supportSize;             /* Allocated size of supportSet */
     BddCache applycache;         /* Cache for apply results */
     BddCache itecache;           /* Cache for ITE results */
     BddCache quantcache;         /* Cache for exist/forall results */
@@ -561,11 +561,7 @@ BddTree *masterbdd::reorder_sift(BddTree *t)
 
       /* Sort according to the number of nodes at each level */
    std::sort(p, p + num, [] (const sizePair& a, const sizePair& b) {
-     if (a.val < b.val)
-       return -1;
-     if (a.val > b.val)
-       return 1;
-     return 0;
+     return a.val < b.val;
    });
 
       /* Create sequence */
@@ -1550,8 +1546,17 @@ int masterbdd::reorder_init(void)
 {
    int n;
 
+      /* The unique table is not used while reordering, nodes are chained
+       * per level in bddhash instead */
+   if ((bddhash=(int*)calloc(bddnodesize, sizeof(*bddhash))) == NULL)
+      return -1;
+
    if ((levels=NEW(levelData,bddvarnum)) == NULL)
+   {
+      free(bddhash);
+      bddhash = NULL;
       return -1;
+   }
 
    for (n=0 ; n<bddvarnum ; n++)
    {
@@ -1606,6 +1611,8 @@ void masterbdd::reorder_done(void)
 #endif
    free(extroots);
    free(levels);
+   free(bddhash);
+   bddhash = NULL;
    iactmtx.reset (0);
    bdd_gbc();
 }
@@ -1653,13 +1660,7 @@ BddTree *masterbdd::reorder_block(BddTree *t, int method)
 
    if (t->seq != NULL)
      std::sort (t->seq, t->seq + (t->last-t->first+1), [&] (int aa, int bb) {
-         int a = bddvar2level[aa];
-         int b = bddvar2level[bb];
-         if (a < b)
-           return -1;
-         if (a > b)
-           return 1;
-         return 0;
+         return bddvar2level[aa] < bddvar2level[bb];
        });
 
    return t;
@@ -2111,6 +2112,21 @@ void masterbdd::bdd_varblockall(void)
 }
 
 
+/*
+NAME    {* bdd\_hasvarblocks *}
+SECTION {* reorder *}
+SHORT   {* tells whether variable blocks were added *}
+PROTO   {* int bdd_hasvarblocks(void) *}
+DESCR   {* Returns nonzero if variable blocks were added since the last
+	   call to {\tt bdd\_clrvarblocks}. *}
+ALSO    {* bdd\_addvarblock, bdd\_varblockall *}
+*/
+int masterbdd::bdd_hasvarblocks(void) const
+{
+   return vartree != NULL;
+}
+
+
 /*
 NAME    {* bdd\_printorder *}
 SECTION {* reorder *}
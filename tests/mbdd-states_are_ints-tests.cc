@@ -2,6 +2,7 @@
 #include <meta_bdd_states_are_ints/meta_bdd.hh>
 #include <utils/bdd_io.hh>
 #include <signal.h>
+#include <thread>
 #include <utils/debugbreak.h>
 #include <utils/transduct_bdd.hh>
 using utils::transduct;
@@ -258,6 +259,89 @@ int main () {
     }
   } (sylvan::BddMap ());
 
+  [&] (auto f) {
+    if constexpr (is_buddy or is_abc) {
+      // Quantifications with the same arguments have distinct cache entries.
+      test (f.ExistAbstract (x1).isOne ());
+      test (f.UnivAbstract (x1) == x0);
+      test (f.AndAbstract (!x0, x0) == x1);
+      test (f.AndNot (x0) == !x0 * x1);
+      test (f.Xnor (x2) == !(f ^ x2));
+      auto map = Bdd::remap_t ();
+      map[0] = x1 * x2;
+      test (f.Remap (map) == x1);
+      // Changing a map that was used drops what was built from it.
+      map[0] = !x1;
+      test (f.Remap (map).isOne ());
+    }
+    if constexpr (is_abc) {
+      test ((f ^ x2) == (f * !x2 + !f * x2));
+      test (f.Ite (x2, !x2) == !(f ^ x2));
+      test (f.Ite (x2, x3) == (f * x2 + !f * x3));
+
+      // Labels of a second manager can be used alongside, and copied back.
+      auto main_manager = utils::abcbdd::manager ();
+      auto other_manager = utils::abcbdd::init (10, 16);
+      auto g = f.CopyTo (other_manager);
+      test (g != f);
+      test ((g * !Bdd::bddVar (0)) == Bdd::bddVar (1) * !Bdd::bddVar (0));
+      test ((g ^ g).isZero ());
+      utils::abcbdd::set_manager (main_manager);
+      test (g.CopyTo (main_manager) == f);
+    }
+    if constexpr (is_buddy) {
+      // BuDDy managers share no state, so a thread can use one of its own
+      // alongside this one.
+      masterbdd other_manager {};
+      auto support_ok = false;
+      auto worker = std::thread ([&] {
+        other_manager.bdd_init (1 << 10, 1 << 10);
+        other_manager.bdd_setvarnum (10);
+        auto g = other_manager.bdd_addref (other_manager.bdd_apply (other_manager.bdd_ithvar (3),
+                                                                    other_manager.bdd_ithvar (7),
+                                                                    bddop_and));
+        support_ok = other_manager.bdd_support (g) == g;
+      });
+      test ((f * x2).Support () == x0 * x1 * x2);
+      worker.join ();
+      test (support_ok);
+      other_manager.bdd_done ();
+    }
+  } (x0 + x1);
+
+  if constexpr (is_buddy or is_abc) {
+    // Labels are reference counted, so collecting keeps them alive.
+    if constexpr (is_buddy)
+      global_mbuddy.bdd_gbc ();
+    else
+      utils::abcbdd::gc ();
+    // Reuse the freed nodes.
+    auto junk = Bdd::bddZero ();
+    for (int i = 2; i < 60; ++i)
+      junk = junk ^ (Bdd::bddVar (i) * !Bdd::bddVar (i / 2));
+    // Cached negations do not outlive the nodes they were computed on.
+    test ((!junk) == (junk ^ Bdd::bddOne ()));
+    test ((!!junk) == junk);
+    test (q1.accepts ({ !x0 * x1, x1 }));
+    test (not q1.accepts ({ !x0 * !x1, !x0 * !x1 }));
+    test ((q1 & q4) == q5);
+    test (flat_automaton ({x0, !x0, Bdd::bddZero (), x1, x1}) == q1);
+  }
+
+  if constexpr (is_buddy) {
+    // Handles survive reordering; this function is smaller with x0, x3
+    // adjacent, and so on.
+    auto x4 = Bdd::bddVar (4), x5 = Bdd::bddVar (5);
+    auto f = x0 * x3 + x1 * x4 + x2 * x5;
+    utils::buddybdd::reorder ();
+    test (f == x0 * x3 + x1 * x4 + x2 * x5);
+    test (f.ExistAbstract (x0 * x1) == x2 * x5 + x3 + x4);
+    test ((!f) == (!x0 + !x3) * (!x1 + !x4) * (!x2 + !x5));
+    test (q1.accepts ({ !x0 * x1, x1 }));
+    test ((q1 & q4) == q5);
+    test (flat_automaton ({x0, !x0, Bdd::bddZero (), x1, x1}) == q1);
+  }
+
   if constexpr (is_sylvan) sylvan::sylvan_quit ();
 
   return global_res ? 0 : 1;
@@ -59,6 +59,8 @@ int main () {
   test (q.accepts ({ x0 * !x1, x0 * x1, !x1 }));
   test (not q.accepts ({ !x0 * x1 }));
   test (not q.accepts ({ x0 * x1, x0 * x1, !x1 }));
+  test (q.accepts_valuations (1, [] (size_t, int var) { return var == 0; }));
+  test (not q.accepts_valuations (3, [] (size_t k, int var) { return k > 0 or var < 2; }));
 
   test (mmbdd.full ().accepts ({ x0, x0, x0, x0 }));
   test (not mmbdd.empty ().accepts ({ x0, x0, x0, x0 }));
@@ -123,6 +125,21 @@ int main () {
   test ((q | q6) == q7);
   test ((q | q6) == (q6 | q));
 
+  // Batched products
+  {
+    using request = decltype (mmbdd)::product_request;
+    auto reqs = std::vector<request> {
+      {true, q1, q4}, {false, q, q6}, {true, q5p, q5pp}, {true, q4, q1}, {false, q5, mmbdd.empty ()}
+    };
+    auto res = mmbdd.products (reqs);
+    test (res.size () == 5);
+    test (res[0] == q5);
+    test (res[1] == q7);
+    test (res[2] == q5pi);
+    test (res[3] == q5);
+    test (res[4] == q5);
+  }
+
   // Print a word per state
   for (auto&& state : mmbdd) {
     if (state == mmbdd.self ())
@@ -198,6 +215,21 @@ int main () {
     test (comp.rejects ({!x2 * !x3}));
   }
 
+  // Interleaved variables, as in upsets: x1 is the output for x0.
+  {
+    auto neg = mmbdd.make ((x0 * !x1 + !x0 * x1) * mmbdd.self (), true);
+    auto comp = transduct (qq8, neg, {x1}, {x0});
+    test (comp.accepts ({!x0, !x0}));
+    test (comp.rejects ({!x0, x0}));
+    test (comp == transduct (qq8, neg, {x1}, {x0}));
+
+    // Labels that use other variables are projected, as with any other map.
+    auto q = mmbdd.make ((x0 * x2) * mmbdd.self () + !(x0 * x2) * mmbdd.empty (), true);
+    auto comp2 = transduct (q, neg, {x1}, {x0});
+    test (comp2.accepts ({!x0 * !x2, !x0 * x2}));
+    test (comp2.rejects ({x0}));
+  }
+
   {
     auto q1 = flat_automaton ({x0, !x0, Bdd::bddZero (), x1, x1});
     auto q = q1.apply ([&] (const Bdd& b) {
@@ -215,6 +247,12 @@ int main () {
             }));
   }
 
+  // Transitions are only protected by the master's mark callback.
+  sylvan::sylvan_gc ();
+  test (q1.accepts ({ !x0 * x1, x1 }));
+  test (not q1.accepts ({ !x0 * !x1, !x0 * !x1 }));
+  test (flat_automaton ({x0, !x0, Bdd::bddZero (), x1, x1}) == q1);
+
   sylvan::sylvan_quit();
 
   return global_res ? 0 : 1;
@@ -0,0 +1,80 @@
+#include <upset/upset_adhoc.hh>
+
+#include <labels/truthtable.hh>
+#include <utils/bdd_io.hh>
+
+#include "tests.hh"
+
+auto mmbdd = MBDD::make_master_meta_bdd<labels::truthtable<4>, MBDD::states_are_ints> ();
+// Spans several words.
+auto mmbdd_wide = MBDD::make_master_meta_bdd<labels::truthtable<9>, MBDD::states_are_ints> ();
+
+using upset_tt = upset::upset_adhoc<decltype (mmbdd)>;
+using upset_tt_wide = upset::upset_adhoc<decltype (mmbdd_wide)>;
+
+template <size_t N>
+void test_labels () {
+  using Bdd = labels::truthtable<N>;
+  auto x0 = Bdd::bddVar (0), x1 = Bdd::bddVar (1), xl = Bdd::bddVar (N - 1);
+
+  test ((x0 * !x0).empty ());
+  test ((x0 + !x0) == Bdd::fullset ());
+  test (not (x0 * x1 * xl).empty ());
+  test ((x0 ^ x1) == (x0 * !x1 + !x0 * x1));
+  test (x0.AndNot (xl) == (x0 * !xl));
+  test (x0.Xnor (xl) == !(x0 ^ xl));
+  test (x0.Ite (x1, xl) == (x0 * x1 + !x0 * xl));
+
+  auto&& [only_this, common, only_other] = Bdd (x0).partition (x1);
+  test (only_this == (x0 * !x1) and common == (x0 * x1) and only_other == (!x0 * x1));
+
+  test ((x1 * xl).TopVar () == 1);
+  test ((x1 * xl).Then () == xl);
+  test ((x1 * xl).Else ().isZero ());
+  test (xl.TopVar () == (int) N - 1);
+
+  auto map = typename Bdd::remap_t ();
+  map[N - 1] = !Bdd::bddVar (N - 1);
+  test ((x0 * xl).Remap (map) == (x0 * !xl));
+  map[0] = x1;
+  test ((x0 * xl).Remap (map) == (x1 * !xl));
+}
+
+int main () {
+  test_labels<3> ();
+  test_labels<6> ();
+  test_labels<9> ();
+
+  mmbdd.init ();
+  mmbdd_wide.init ();
+
+  {
+    auto u = upset_tt (mmbdd, {2, 1});
+    u += {5, 1};
+    test (not u.contains ({6, 1}));
+    test (not u.contains ({7, 1}));
+    test (u.contains ({9, 2}));
+    test (u.contains ({10, 2}));
+    test (not u.contains ({0, 1}));
+  }
+
+  {
+    auto u = upset_tt (mmbdd, {3, 1, 4, 9});
+    u += {3, 2, 3, 0};
+    test (u.contains ({6, 3, 7, 9}));
+    test (not u.contains ({5, 3, 7, 9}));
+    test (not u.contains ({6, 3, 7, 8}));
+    test ((u | upset_tt (mmbdd, {6, 3, 7, 9})) == u);
+  }
+
+  {
+    auto u = upset_tt_wide (mmbdd_wide, {3, 1, 4, 9, 0, 0, 0, 0, 2});
+    u += {3, 2, 3, 0, 0, 0, 0, 1, -1};
+    test (u.contains ({6, 3, 7, 9, 0, 0, 0, 1, 1}));
+    test (not u.contains ({6, 3, 7, 9, 0, 0, 0, 0, 1}));
+    test (not u.contains ({6, 3, 7, 9, 0, 0, 0, 1, 0}));
+    test ((u & upset_tt_wide (mmbdd_wide, {0, 0, 0, 0, 0, 0, 0, 0, 0})) == u);
+  }
+
+  return global_res ? 0 : 1;
+}
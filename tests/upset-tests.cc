@@ -1,6 +1,7 @@
 #include <algorithm>
 
 #include <upset/upset_adhoc.hh>
+#include <upset/upset_bdd.hh>
 
 using namespace std::literals;
 
@@ -307,6 +308,139 @@ int main (int argc, char** argv) {
         full_test ({ 12, 11, 10, 9, 8 });
       }},
 
+
+    { "R",
+      [] () {
+        auto u = upset_bdd (mmbdd, {3, 1, 4, 9}) | upset_bdd (mmbdd, {1, 3, 2, 2});
+        auto vs = std::vector<std::vector<ssize_t>> {
+          {3, 1, 4, 9}, {0, 0, 0, 0}, {1, 3, 2, 1}, {1, 3, 2, 2}, {2, 0, 0, 3}, {1024, 1, 4, 9}
+        };
+        auto res = u.contains (vs);
+        test (res == std::vector<bool> ({true, false, false, true, false, true}));
+        // The same as reading the vectors as words of letters.
+        for (size_t i = 0; i < vs.size (); ++i) {
+          auto v = vs[i];
+          auto w = std::vector<mmbdd_t::letter_type> ();
+          do {
+            auto l = mmbdd_t::letter_type (mmbdd_t::letter_set_type::bddOne ());
+            for (size_t j = 0; j < v.size (); ++j) {
+              auto x = mmbdd_t::letter_set_type::bddVar (j);
+              l = l * ((v[j] & 1) ? x : !x);
+              v[j] >>= 1;
+            }
+            w.push_back (l);
+          } while (std::ranges::any_of (v, [] (auto x) { return x != 0; }));
+          test (res[i] == u.get_mbdd ().accepts (w));
+        }
+      }},
+
+
+    { "S",
+      [] () {
+        // Built in one pass, this is the intersection of the closures of each value.
+        auto u = upset_bdd (mmbdd, {5, 0, 12, 1});
+        test (u == (upset_bdd (mmbdd, {5, 0, 0, 0}) & upset_bdd (mmbdd, {0, 0, 12, 0}) &
+                    upset_bdd (mmbdd, {0, 0, 0, 1})));
+        test (upset_bdd (mmbdd, {1, 1}) == (upset_bdd (mmbdd, {1, 0}) & upset_bdd (mmbdd, {0, 1})));
+      }},
+
+
+    { "T",
+      [] () {
+        auto vs = std::vector<std::vector<ssize_t>> {
+          {3, 1, 4}, {1, 5, 9}, {2, 6, 5}, {3, 5, 8}, {9, 7, 9}, {3, 2, 3}, {8, 4, 6}, {2, 6, 4}, {3, 1, 4}
+        };
+        auto u = upset_bdd (mmbdd, vs.front ());
+        for (auto&& v : vs)
+          u |= upset_bdd (mmbdd, v);
+        test (upset_bdd (mmbdd, vs) == u);
+        test (upset_bdd (mmbdd, std::span (vs).first (1)) == upset_bdd (mmbdd, vs.front ()));
+      }},
+
+
+    { "U",
+      [] () {
+        // Predecessors through a transition, in one pass per dimension.
+        auto u = upset_bdd (mmbdd, {3, 1, 4, 9}) | upset_bdd (mmbdd, {1, 3, 2, 2});
+        for (auto&& [delta, budget] : std::vector<std::pair<std::vector<ssize_t>, std::vector<ssize_t>>> {
+            {{1, 0, -2, 1}, {1, 0, 0, 3}}, {{0, 0, 0, 0}, {2, 2, 2, 2}}, {{-3, 1, 0, 5}, {0, 1, 0, 7}},
+            {{2, 2, 2, 2}, {0, 0, 0, 0}}, {{1, -1, 0, 0}, {13, 0, 1, 0}}})
+          test (u.pre (delta, budget) == ((u + delta) & budget));
+      }},
+
+
+    { "V",
+      [] () {
+        auto u = upset_bdd (mmbdd, {3, 1, 4, 9}) | upset_bdd (mmbdd, {1, 3, 2, 2});
+        auto deltas = std::vector<std::vector<ssize_t>> {
+          {1, 0, -2, 1}, {0, 0, 0, 0}, {1, 0, -2, 1}, {-3, 1, 0, 5}, {1, 0, -2, 1}
+        };
+        auto budgets = std::vector<std::vector<ssize_t>> {
+          {1, 0, 0, 3}, {2, 2, 2, 2}, {1, 0, 1, 3}, {0, 1, 0, 7}, {0, 0, 0, 4}
+        };
+        auto res = u.pre (deltas[0], budgets[0]);
+        for (size_t t = 1; t < deltas.size (); ++t)
+          res |= u.pre (deltas[t], budgets[t]);
+        test (u.pre_all (deltas, budgets) == res);
+        test (u.pre_all (std::span (deltas).first (1), std::span (budgets).first (1)) ==
+              u.pre (deltas[0], budgets[0]));
+        test (u.pre_all ({}, {}) == upset_bdd (mmbdd, 4));
+        test (upset_bdd (mmbdd, 4).is_empty ());
+      }},
+
+
+    { "W",
+      [] () {
+        // The transducer-based upsets agree with the definitions.
+        using upset_trans = upset::upset<mmbdd_t>;
+        for (auto&& v : std::vector<std::vector<ssize_t>> {{3, 5, 2}, {0, 1, 0}, {7, 0, 4}}) {
+          auto u = upset_trans (mmbdd, v);
+          for (ssize_t i0 = 0; i0 < 9; ++i0)
+            for (ssize_t i1 = 0; i1 < 9; ++i1)
+              for (ssize_t i2 = 0; i2 < 9; ++i2)
+                test (u.contains ({i0, i1, i2}) == (i0 >= v[0] and i1 >= v[1] and i2 >= v[2]));
+        }
+        auto vs = std::vector<std::vector<ssize_t>> {{3, 5, 2}, {1, 6, 0}, {4, 5, 2}};
+        test (upset_trans (mmbdd, vs) == (upset_trans (mmbdd, vs[0]) | upset_trans (mmbdd, vs[1])));
+
+        auto u = upset_trans (mmbdd, {3, 1, 4}) | upset_trans (mmbdd, {1, 3, 2});
+        // x is in u + delta if x - delta is a vector of u.
+        auto in_plus = [&] (ssize_t i0, ssize_t i1, ssize_t i2, const std::vector<ssize_t>& delta) {
+          return (i0 >= delta[0] and i1 >= delta[1] and i2 >= delta[2] and
+                  u.contains ({i0 - delta[0], i1 - delta[1], i2 - delta[2]}));
+        };
+
+        // Deltas that are consumed while a carry is still pending, so that
+        // the transducers loop on their own state.
+        for (auto&& delta : std::vector<std::vector<ssize_t>> {
+            {1, 0, -2}, {0, 0, 0}, {-3, 1, 5}, {7, -1, 3}, {0, 4, 0}}) {
+          auto sum = u ^ delta;
+          test (sum == u + delta);
+          for (ssize_t i0 = 0; i0 < 12; ++i0)
+            for (ssize_t i1 = 0; i1 < 8; ++i1)
+              for (ssize_t i2 = 0; i2 < 10; ++i2)
+                test (sum.contains ({i0, i1, i2}) == in_plus (i0, i1, i2, delta));
+        }
+
+        auto deltas = std::vector<std::vector<ssize_t>> {{1, 0, -2}, {0, 0, 0}, {1, 0, -2}, {-3, 1, 5}};
+        auto budgets = std::vector<std::vector<ssize_t>> {{1, 0, 3}, {2, 2, 2}, {1, 1, 3}, {0, 1, 7}};
+        for (size_t t = 0; t < deltas.size (); ++t) {
+          auto pre = u.pre (deltas[t], budgets[t]);
+          test (pre == ((u + deltas[t]) & budgets[t]));
+          for (ssize_t i0 = 0; i0 < 8; ++i0)
+            for (ssize_t i1 = 0; i1 < 6; ++i1)
+              for (ssize_t i2 = 0; i2 < 12; ++i2)
+                test (pre.contains ({i0, i1, i2}) ==
+                      (i0 >= budgets[t][0] and i1 >= budgets[t][1] and i2 >= budgets[t][2] and
+                       in_plus (i0, i1, i2, deltas[t])));
+        }
+        auto res = u.pre (deltas[0], budgets[0]);
+        for (size_t t = 1; t < deltas.size (); ++t)
+          res |= u.pre (deltas[t], budgets[t]);
+        test (u.pre_all (deltas, budgets) == res);
+        test (u.pre_all ({}, {}) == upset_trans (mmbdd, 3));
+      }},
+
   };
 
   if (argc > 1 and argv[1] == "-x"sv) {